@@ -24,8 +24,8 @@ namespace mio
                 std::string address_;
                 boost::asio::io_context &io_context_;
 
-                std::shared_ptr<boost::interprocess::managed_shared_memory> shared_memory_;
-                parallelism::ring_queue<detail::request> *request_queue_ = nullptr;
+                std::shared_ptr<interprocess::managed_shared_memory> shared_memory_;
+                detail::request_queue_t *request_queue_ = nullptr;
 
             public:
                 acceptor(boost::asio::io_context &io_context) : io_context_(io_context)
@@ -43,9 +43,9 @@ namespace mio
 
                     address_ = address;
                     shared_memory_object::remove(address_.c_str());
-                    shared_memory_ = std::make_shared<managed_shared_memory>(create_only, address.c_str(), 128 * 1024 * 1024);
+                    shared_memory_ = std::make_shared<interprocess::managed_shared_memory>(create_only, address.c_str(), 128 * 1024 * 1024);
 
-                    request_queue_ = shared_memory_->construct<std::remove_reference<decltype(*request_queue_)>::type>("request_queue")();
+                    request_queue_ = shared_memory_->construct<detail::request_queue_t>("request_queue")(detail::REQUEST_QUEUE_SIZE, detail::request_queue_t::allocator_type(shared_memory_->get_segment_manager()));
                 }
 
                 void accept(socket &peer)
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "mio/parallelism/channel.hpp"
+#include "mio/parallelism/ring_queue.hpp"
+#include "mio/interprocess/shared_memory.hpp"
 #include <boost/interprocess/managed_shared_memory.hpp>
 
 namespace mio
@@ -11,11 +13,21 @@ namespace mio
         {
             namespace detail
             {
+                //通道及其缓冲区都分配在共享内存中
+                using channel_t = parallelism::channel<char, interprocess::allocator<char>, parallelism::dynamic_extent, parallelism::wait::event>;
+
+                //每个方向默认的容量
+                static constexpr size_t CHANNEL_SIZE = 4096;
+
                 struct request
                 {
-                    boost::interprocess::offset_ptr<parallelism::channel<char>> channel_ptr;
+                    boost::interprocess::offset_ptr<channel_t> channel_ptr;
                 };
 
+                using request_queue_t = parallelism::ring_queue<request, interprocess::allocator<request>>;
+
+                static constexpr size_t REQUEST_QUEUE_SIZE = 1024;
+
             } // namespace detail
         }     // namespace pipe
     }         // namespace ipc
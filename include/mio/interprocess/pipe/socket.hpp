@@ -24,10 +24,10 @@ namespace mio
                 std::string address_;
                 boost::asio::io_context &io_context_;
 
-                std::shared_ptr<boost::interprocess::managed_shared_memory> shared_memory_;
-                parallelism::channel<char> *channel_ = nullptr;
+                std::shared_ptr<interprocess::managed_shared_memory> shared_memory_;
+                detail::channel_t *channel_ = nullptr;
 
-                parallelism::ring_queue<detail::request> *request_queue_;
+                detail::request_queue_t *request_queue_;
 
                 bool is_clinet_;
 
@@ -52,14 +52,15 @@ namespace mio
                     other.channel_ = nullptr;
                 }
 
-                void connect(const std::string &address)
+                //client_size 与 server_size 为两个方向的缓冲区容量
+                void connect(const std::string &address, size_t client_size = detail::CHANNEL_SIZE, size_t server_size = detail::CHANNEL_SIZE)
                 {
                     using namespace boost::interprocess;
 
                     address_ = address;
-                    shared_memory_ = std::make_unique<managed_shared_memory>(open_only, address.c_str());
-                    request_queue_ = shared_memory_->find<std::remove_reference<decltype(*request_queue_)>::type>("request_queue").first;
-                    channel_ = shared_memory_->construct<std::remove_reference<decltype(*channel_)>::type>(anonymous_instance)();
+                    shared_memory_ = std::make_unique<interprocess::managed_shared_memory>(open_only, address.c_str());
+                    request_queue_ = shared_memory_->find<detail::request_queue_t>("request_queue").first;
+                    channel_ = shared_memory_->construct<detail::channel_t>(anonymous_instance)(client_size, server_size, detail::channel_t::allocator_type(shared_memory_->get_segment_manager()));
 
                     detail::request req;
                     req.channel_ptr = channel_;
@@ -67,14 +68,14 @@ namespace mio
                 }
 
                 template <typename Yield>
-                void async_connect(const std::string &address, Yield &yield)
+                void async_connect(const std::string &address, Yield &yield, size_t client_size = detail::CHANNEL_SIZE, size_t server_size = detail::CHANNEL_SIZE)
                 {
                     using namespace boost::interprocess;
 
                     address_ = address;
-                    shared_memory_ = std::make_unique<managed_shared_memory>(open_only, address.c_str());
-                    request_queue_ = shared_memory_->find<std::remove_reference<decltype(*request_queue_)>::type>("request_queue").first;
-                    channel_ = shared_memory_->construct<std::remove_reference<decltype(*channel_)>::type>(anonymous_instance)();
+                    shared_memory_ = std::make_unique<interprocess::managed_shared_memory>(open_only, address.c_str());
+                    request_queue_ = shared_memory_->find<detail::request_queue_t>("request_queue").first;
+                    channel_ = shared_memory_->construct<detail::channel_t>(anonymous_instance)(client_size, server_size, detail::channel_t::allocator_type(shared_memory_->get_segment_manager()));
 
                     detail::request req;
                     req.channel_ptr = channel_;
@@ -83,12 +84,12 @@ namespace mio
 
                 size_t write_some(const void *data, size_t size)
                 {
-                    return channel_->write_some(is_clinet_, (char *)data, size);
+                    return channel_->write_some(is_clinet_, (char *)data, size, parallelism::wait::blocking(channel_->writable_event(is_clinet_)));
                 }
 
                 size_t read_some(void *data, size_t size)
                 {
-                    return channel_->read_some(is_clinet_, (char *)data, size);
+                    return channel_->read_some(is_clinet_, (char *)data, size, parallelism::wait::blocking(channel_->readable_event(is_clinet_)));
                 }
 
                 template <typename Yield>
@@ -105,12 +106,12 @@ namespace mio
 
                 size_t write(const void *data, size_t size)
                 {
-                    return channel_->write(is_clinet_, (char *)data, size);
+                    return channel_->write(is_clinet_, (char *)data, size, parallelism::wait::blocking(channel_->writable_event(is_clinet_)));
                 }
 
                 size_t read(void *data, size_t size)
                 {
-                    return channel_->read(is_clinet_, (char *)data, size);
+                    return channel_->read(is_clinet_, (char *)data, size, parallelism::wait::blocking(channel_->readable_event(is_clinet_)));
                 }
 
                 template <typename Yield>
@@ -125,17 +126,48 @@ namespace mio
                     return channel_->read(is_clinet_, (char *)data, size, [&](size_t) { this->io_context_.post(yield); });
                 }
 
+                //[first, last) 中的元素需有 data 与 size 成员, 整条记录一次发布
+                template <typename BufferIt>
+                size_t write_v(BufferIt first, BufferIt last)
+                {
+                    return channel_->write_v(is_clinet_, first, last, parallelism::wait::blocking(channel_->writable_event(is_clinet_)));
+                }
+
+                template <typename BufferIt>
+                size_t read_v(BufferIt first, BufferIt last)
+                {
+                    return channel_->read_v(is_clinet_, first, last, parallelism::wait::blocking(channel_->readable_event(is_clinet_)));
+                }
+
+                template <typename BufferIt, typename Yield>
+                size_t async_write_v(BufferIt first, BufferIt last, Yield &yield)
+                {
+                    return channel_->write_v(is_clinet_, first, last, [&](size_t) { this->io_context_.post(yield); });
+                }
+
+                template <typename BufferIt, typename Yield>
+                size_t async_read_v(BufferIt first, BufferIt last, Yield &yield)
+                {
+                    return channel_->read_v(is_clinet_, first, last, [&](size_t) { this->io_context_.post(yield); });
+                }
+
+                //关闭读取 写入 或两者, how 取 channel 的 SHUT_READ SHUT_WRITE SHUT_BOTH
+                void shutdown(uint8_t how)
+                {
+                    channel_->shutdown(is_clinet_, how);
+                }
+
                 void close()
                 {
                      using namespace boost::interprocess;
                      
                     if (channel_ != nullptr)
                     {
-                        if (channel_->get_status() == parallelism::channel<char>::DISCONNECTED)
+                        //先关闭 再由后关闭的一端释放
+                        if (channel_->close())
                         {
                             shared_memory_->destroy_ptr(channel_);
                         }
-                        channel_->close();
 
                         shared_memory_object::remove(address_.c_str());
                         channel_ = nullptr;
@@ -3,6 +3,7 @@
 #include <string>
 #include <stddef.h>
 #include <memory>
+#include <initializer_list>
 
 namespace mio
 {
@@ -10,6 +11,19 @@ namespace mio
     {
         namespace detail
         {
+            //分散/聚集读写的一段内存
+            struct const_buffer
+            {
+                const void *data;
+                size_t size;
+            };
+
+            struct mutable_buffer
+            {
+                void *data;
+                size_t size;
+            };
+
             class basic_socket
             {
             public:
@@ -19,6 +33,11 @@ namespace mio
 
                 virtual size_t read(void *data, size_t size) = 0;
 
+                //多段数据作为一条记录写入
+                virtual size_t write_v(std::initializer_list<const_buffer> buffers) = 0;
+
+                virtual size_t read_v(std::initializer_list<mutable_buffer> buffers) = 0;
+
                 virtual void close() = 0;
 
                 virtual ~basic_socket() = default;
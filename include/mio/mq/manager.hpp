@@ -81,12 +81,13 @@ namespace mio
                             uint64_t name_size = msg.first->name.size();
                             uint64_t data_size = msg.first->data.size();
 
-                            socket_->write(&msg.first->type, sizeof(msg.first->type));
-                            socket_->write(&msg.first->uuid, sizeof(msg.first->uuid));
-                            socket_->write(&name_size, sizeof(name_size));
-                            socket_->write(&data_size, sizeof(data_size));
-                            socket_->write(&msg.first->name[0], name_size);
-                            socket_->write(&msg.first->data[0], data_size);
+                            //整条消息一次写入
+                            socket_->write_v({{&msg.first->type, sizeof(msg.first->type)},
+                                              {&msg.first->uuid, sizeof(msg.first->uuid)},
+                                              {&name_size, sizeof(name_size)},
+                                              {&data_size, sizeof(data_size)},
+                                              {&msg.first->name[0], name_size},
+                                              {&msg.first->data[0], data_size}});
                         }
                     }
                     catch (const std::exception &e)
@@ -105,16 +106,16 @@ namespace mio
                             uint64_t name_size;
                             uint64_t data_size;
 
-                            socket_->read(&msg->type, sizeof(msg->type));
-                            socket_->read(&msg->uuid, sizeof(msg->uuid));
-                            socket_->read(&name_size, sizeof(name_size));
-                            socket_->read(&data_size, sizeof(data_size));
+                            socket_->read_v({{&msg->type, sizeof(msg->type)},
+                                             {&msg->uuid, sizeof(msg->uuid)},
+                                             {&name_size, sizeof(name_size)},
+                                             {&data_size, sizeof(data_size)}});
 
                             msg->name.resize(name_size);
                             msg->data.resize(data_size);
 
-                            socket_->read(&msg->name[0], name_size);
-                            socket_->read(&msg->data[0], data_size);
+                            socket_->read_v({{&msg->name[0], name_size},
+                                             {&msg->data[0], data_size}});
 
                             if (msg->type == message_type::RESPONSE)
                             {
@@ -43,6 +43,16 @@ namespace mio
                     return socket_t::async_read(data, size, boost::fibers::asio::yield);
                 }
 
+                virtual size_t write_v(std::initializer_list<detail::const_buffer> buffers)
+                {
+                    return socket_t::async_write_v(buffers.begin(), buffers.end(), boost::fibers::asio::yield);
+                }
+
+                virtual size_t read_v(std::initializer_list<detail::mutable_buffer> buffers)
+                {
+                    return socket_t::async_read_v(buffers.begin(), buffers.end(), boost::fibers::asio::yield);
+                }
+
                 virtual void close()
                 {
                     socket_t::close();
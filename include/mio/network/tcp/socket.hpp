@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <boost/asio.hpp>
 
@@ -21,6 +22,26 @@ namespace mio
 
                 boost::asio::ip::tcp::socket socket_;
 
+                template <typename BufferIt>
+                static std::vector<boost::asio::const_buffer> const_buffers(BufferIt first, BufferIt last)
+                {
+                    std::vector<boost::asio::const_buffer> ret;
+                    for (; first != last; ++first)
+                        ret.emplace_back(first->data, first->size);
+
+                    return ret;
+                }
+
+                template <typename BufferIt>
+                static std::vector<boost::asio::mutable_buffer> mutable_buffers(BufferIt first, BufferIt last)
+                {
+                    std::vector<boost::asio::mutable_buffer> ret;
+                    for (; first != last; ++first)
+                        ret.emplace_back(first->data, first->size);
+
+                    return ret;
+                }
+
             public:
                 socket(boost::asio::io_context &io_context) : io_context_(io_context), socket_(io_context_)
                 {
@@ -97,6 +118,31 @@ namespace mio
                     return boost::asio::async_read(socket_, buffer(data, size), yield);
                 }
 
+                //[first, last) 中的元素需有 data 与 size 成员
+                template <typename BufferIt>
+                size_t write_v(BufferIt first, BufferIt last)
+                {
+                    return boost::asio::write(socket_, const_buffers(first, last));
+                }
+
+                template <typename BufferIt>
+                size_t read_v(BufferIt first, BufferIt last)
+                {
+                    return boost::asio::read(socket_, mutable_buffers(first, last));
+                }
+
+                template <typename BufferIt, typename Yield>
+                size_t async_write_v(BufferIt first, BufferIt last, Yield &yield)
+                {
+                    return boost::asio::async_write(socket_, const_buffers(first, last), yield);
+                }
+
+                template <typename BufferIt, typename Yield>
+                size_t async_read_v(BufferIt first, BufferIt last, Yield &yield)
+                {
+                    return boost::asio::async_read(socket_, mutable_buffers(first, last), yield);
+                }
+
                 void close()
                 {
                     socket_.close();
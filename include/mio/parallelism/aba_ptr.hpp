@@ -33,7 +33,7 @@ namespace mio
 
             aba_ptr(T_ *ptr)
             {
-                *this = ptr;
+                ptr_ = (uint64_t)ptr;
             }
 
             ~aba_ptr() = default;
@@ -120,7 +120,7 @@ namespace std
 
         aba_ptr exchange(aba_ptr desired, std::memory_order failure = std::memory_order_seq_cst)
         {
-            return aba_ptr(ptr_.exchange(desired, failure));
+            return aba_ptr(ptr_.exchange(desired.ptr_, failure));
         }
 
         bool compare_exchange_weak(aba_ptr &expected, aba_ptr desired, std::memory_order failure = std::memory_order_seq_cst)
@@ -134,7 +134,7 @@ namespace std
 
         bool compare_exchange_strong(aba_ptr &expected, aba_ptr desired, std::memory_order failure = std::memory_order_seq_cst)
         {
-            uint16_t count = (expected.ptr_ & COUNT_MASK) + 1;
+            uint16_t count = ((expected.ptr_ & COUNT_MASK) >> 48) + 1;
 
             uint64_t des = ((uint64_t)count << 48) + (desired.ptr_ & POINTER_MASK);
             return ptr_.compare_exchange_strong(expected.ptr_, des, failure);
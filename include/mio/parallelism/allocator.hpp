@@ -2,14 +2,24 @@
 
 #include <stddef.h>
 #include <type_traits>
+#include <atomic>
 
+#include "mio/parallelism/utility.hpp"
+
+#if defined(__x86_64__)
+#include "mio/parallelism/tagged_ptr.hpp"
+#else
 #include "mio/parallelism/aba_ptr.hpp"
+#endif
 
 namespace mio
 {
     namespace parallelism
     {
-        template <typename T_>
+        //定长节点分配器, 节点只回收不释放, 析构时统一释放
+        //每个线程对应一个弹匣 在本地分配与回收, 弹匣与全局仓库之间以 MAGAZINE_SIZE_ 个节点为一批交换
+        //仓库为空时 一次申请一整块 MAGAZINE_SIZE_ 个节点
+        template <typename T_, size_t MAGAZINE_SIZE_ = 64, size_t MAGAZINE_NUM_ = 64>
         class allocator
         {
         public:
@@ -19,63 +29,190 @@ namespace mio
             using propagate_on_container_move_assignment = std::true_type;
 
         private:
-            union alignas(alignof(std::atomic<aba_ptr<void>>) > alignof(T_) ? alignof(std::atomic<aba_ptr<void>>) : alignof(T_)) node
+            union node;
+
+            //带计数的表头, x86-64 上为 128 位 CAS 的 tagged_ptr, 其他平台为计数占指针高 16 位的 aba_ptr
+#if defined(__x86_64__)
+            using head_ptr = tagged_ptr<node>;
+#else
+            using head_ptr = aba_ptr<node>;
+#endif
+
+            //空闲节点的链接, next 用于全局链表, chain 用于弹匣与批次内部
+            //全局链表的表头带计数, 弹出时读到已被取走的节点也只会导致 CAS 失败
+            struct link
+            {
+                std::atomic<node *> next;
+                node *chain;
+            };
+
+            union alignas(alignof(link) > alignof(T_) ? alignof(link) : alignof(T_)) node
             {
-                std::atomic<aba_ptr<node>> next;
+                link free;
                 char data[sizeof(T_)];
             };
 
-            std::atomic<aba_ptr<node>> free_list;
+            //一次申请的一整块节点
+            struct alignas(CACHE_LINE) slab
+            {
+                node nodes[MAGAZINE_SIZE_];
+                slab *next;
+            };
 
-        public:
-            allocator()
+            //线程本地的弹匣, busy 防止两个线程映射到同一个弹匣
+            struct alignas(CACHE_LINE) magazine
+            {
+                std::atomic<bool> busy = false;
+                node *head = nullptr;
+                size_t count = 0;
+            };
+
+            magazine magazines_[MAGAZINE_NUM_];
+
+            //全局仓库, 每一项是一批 MAGAZINE_SIZE_ 个节点
+            alignas(CACHE_LINE) std::atomic<head_ptr> depot_;
+
+            //弹匣被占用时使用的单节点空闲链表
+            alignas(CACHE_LINE) std::atomic<head_ptr> free_list_;
+
+            alignas(CACHE_LINE) std::atomic<slab *> slab_list_;
+
+            //取出一批节点, 仓库为空时申请新的一块
+            node *take_batch()
             {
-                free_list = nullptr;
+                head_ptr exp = depot_;
+
+                while (exp && !depot_.compare_exchange_weak(exp, exp->free.next.load()))
+                    ;
+
+                if (exp)
+                    return exp;
+
+                slab *s = new slab;
+                for (size_t i = 0; i + 1 < MAGAZINE_SIZE_; i++)
+                    s->nodes[i].free.chain = &s->nodes[i + 1];
+                s->nodes[MAGAZINE_SIZE_ - 1].free.chain = nullptr;
+
+                s->next = slab_list_;
+                while (!slab_list_.compare_exchange_weak(s->next, s))
+                    ;
+
+                return &s->nodes[0];
             }
 
-            ~allocator()
+            //归还一批节点
+            void put_batch(node *batch)
             {
-                while (free_list.load())
+                head_ptr exp = depot_;
+
+                batch->free.next = exp;
+                while (!depot_.compare_exchange_weak(exp, batch))
                 {
-                    aba_ptr<node> next = free_list.load()->next;
+                    batch->free.next = exp;
+                }
+            }
+
+            //弹匣被占用时 从单节点链表分配
+            node *allocate_shared()
+            {
+                head_ptr exp = free_list_;
 
-                    delete free_list.load();
+                while (exp && !free_list_.compare_exchange_weak(exp, exp->free.next.load()))
+                    ;
 
-                    free_list = next;
+                if (exp)
+                    return exp;
+
+                //取一批, 留下第一个, 其余挂到单节点链表上
+                node *batch = this->take_batch();
+                for (node *n = batch->free.chain; n; n = n->free.chain)
+                    this->deallocate_shared(n);
+
+                return batch;
+            }
+
+            void deallocate_shared(node *p)
+            {
+                head_ptr exp = free_list_;
+
+                p->free.next = exp;
+                while (!free_list_.compare_exchange_weak(exp, p))
+                {
+                    p->free.next = exp;
                 }
             }
 
-            aba_ptr<T_> allocate()
+        public:
+            allocator()
             {
-                aba_ptr<node> exp = free_list;
-                aba_ptr<node> ret = exp;
+                depot_ = head_ptr(nullptr);
+                free_list_ = head_ptr(nullptr);
+                slab_list_ = nullptr;
+            }
 
-                while (!exp || !free_list.compare_exchange_weak(exp, exp->next))
+            allocator(const allocator &) = delete;
+            allocator &operator=(const allocator &) = delete;
+
+            ~allocator()
+            {
+                slab *s = slab_list_;
+                while (s)
                 {
-                    if (exp == nullptr)
-                    {
-                        ret = new node;
-                        return static_cast<aba_ptr<T_>>(ret);
-                    }
+                    slab *next = s->next;
+                    delete s;
+                    s = next;
+                }
+            }
+
+            T_ *allocate()
+            {
+                magazine &m = magazines_[thread_index() % MAGAZINE_NUM_];
+                if (m.busy.exchange(true, std::memory_order_acquire))
+                    return reinterpret_cast<T_ *>(this->allocate_shared());
 
-                    ret = exp;
+                if (!m.head)
+                {
+                    m.head = this->take_batch();
+                    m.count = MAGAZINE_SIZE_;
                 }
 
-                return static_cast<aba_ptr<T_>>(ret);
+                node *ret = m.head;
+                m.head = ret->free.chain;
+                m.count--;
+
+                m.busy.store(false, std::memory_order_release);
+                return reinterpret_cast<T_ *>(ret);
             }
 
-            void deallocate(aba_ptr<T_> p)
+            void deallocate(T_ *p)
             {
-                aba_ptr<node> n = static_cast<aba_ptr<node>>(p);
-                aba_ptr<node> exp = free_list;
+                node *n = reinterpret_cast<node *>(p);
 
-                n->next = exp;
-                while (!free_list.compare_exchange_weak(exp, n))
+                magazine &m = magazines_[thread_index() % MAGAZINE_NUM_];
+                if (m.busy.exchange(true, std::memory_order_acquire))
+                    return this->deallocate_shared(n);
+
+                n->free.chain = m.head;
+                m.head = n;
+                m.count++;
+
+                //弹匣满两批时 把一批还给仓库
+                if (m.count == MAGAZINE_SIZE_ * 2)
                 {
-                    n->next = exp;
+                    node *last = m.head;
+                    for (size_t i = 1; i < MAGAZINE_SIZE_; i++)
+                        last = last->free.chain;
+
+                    node *batch = m.head;
+                    m.head = last->free.chain;
+                    last->free.chain = nullptr;
+                    m.count -= MAGAZINE_SIZE_;
+
+                    this->put_batch(batch);
                 }
+
+                m.busy.store(false, std::memory_order_release);
             }
         };
     } // namespace parallelism
 } // namespace mio
-
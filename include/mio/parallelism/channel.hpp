@@ -3,6 +3,8 @@
 #include <stdint.h>
 
 #include <atomic>
+#include <stdexcept>
+#include <algorithm>
 
 #include "mio/parallelism/pipe.hpp"
 
@@ -10,69 +12,239 @@ namespace mio
 {
     namespace parallelism
     {
-        template <typename T_, size_t N_ = 4096>
+        //双向通道, 每个方向一个 pipe
+        //容量可在编译期给出 或在构造时为每个方向分别指定, 缓冲区经由 Allocator 分配
+        //需要阻塞读写时 Event 使用 wait::event
+        template <typename T_, typename Allocator = std::allocator<T_>, size_t N_ = dynamic_extent, typename Event = wait::null_event>
         class channel
         {
         public:
+            using pipe_type = mio::parallelism::pipe<T_, Allocator, N_, Event>;
+
+            using allocator_type = typename pipe_type::allocator_type;
+
+            using size_type = typename pipe_type::size_type;
+
             static constexpr uint8_t CONNECTED = 0;
             static constexpr uint8_t DISCONNECTED = 1;
 
+            //shutdown 的方向
+            static constexpr uint8_t SHUT_READ = 1;
+            static constexpr uint8_t SHUT_WRITE = 2;
+            static constexpr uint8_t SHUT_BOTH = SHUT_READ | SHUT_WRITE;
+
+            //对端已关闭写入 且剩余数据不足
+            class end_of_stream : public std::runtime_error
+            {
+            public:
+                end_of_stream()
+                    : std::runtime_error("The peer has shut down writing")
+                {
+                }
+            };
+
         private:
-            mio::parallelism::pipe<T_, N_> pipe_[2];
+            //每个方向管道的状态
+            static constexpr uint8_t WRITER_CLOSED = 1;
+            static constexpr uint8_t READER_CLOSED = 2;
+
+            //pipe_[0] 由 fd 为 true 的一端写入, pipe_[1] 由另一端写入
+            pipe_type pipe_[2];
+            std::atomic<uint8_t> state_[2] = {0, 0};
             std::atomic<uint8_t> status_ = CONNECTED;
 
+            //fd 写入的方向
+            static size_t write_side(bool fd)
+            {
+                return fd ? 0 : 1;
+            }
+
+            //fd 读取的方向
+            static size_t read_side(bool fd)
+            {
+                return fd ? 1 : 0;
+            }
+
+            void check_write(bool fd)
+            {
+                uint8_t state = this->state_[write_side(fd)];
+                if (this->status_ == DISCONNECTED || (state & READER_CLOSED))
+                    throw std::runtime_error("The peer is disconnected");
+
+                if (state & WRITER_CLOSED)
+                    throw std::runtime_error("The channel is shut down for writing");
+            }
+
+            //等待 count 个数据时检查, 对端关闭写入后 先读完剩余数据
+            void check_read(bool fd, size_t count)
+            {
+                size_t side = read_side(fd);
+                uint8_t state = this->state_[side];
+                if (this->status_ == DISCONNECTED)
+                    throw std::runtime_error("The peer is disconnected");
+
+                if (state & READER_CLOSED)
+                    throw std::runtime_error("The channel is shut down for reading");
+
+                //先读状态 再读数据量, 关闭写入之前写入的数据都能读到
+                if ((state & WRITER_CLOSED) && this->pipe_[side].size() < count)
+                    throw end_of_stream();
+            }
+
         public:
-            channel() = default;
+            channel()
+                : pipe_{N_, N_}
+            {
+                static_assert(N_ != dynamic_extent, "a runtime sized channel needs max_size");
+            }
 
-            template <typename InputIt>
-            size_t write_some(bool fd, InputIt first, size_t count, const wait::handler_t &handler = wait::yield)
+            //两个方向容量相同
+            channel(size_type max_size, const allocator_type &allocator = allocator_type())
+                : channel(max_size, max_size, allocator)
             {
+            }
+
+            //client_size 为 fd 为 true 的一端写入方向的容量, server_size 为另一方向的容量
+            channel(size_type client_size, size_type server_size, const allocator_type &allocator = allocator_type())
+                : pipe_{{client_size, allocator}, {server_size, allocator}}
+            {
+            }
+
+            //fd 写入方向的容量
+            size_type max_size(bool fd) const
+            {
+                return this->pipe_[write_side(fd)].max_size();
+            }
+
+            template <typename InputIt, typename Handler = wait::yield_t>
+            size_t write_some(bool fd, InputIt first, size_t count, Handler &&handler = Handler())
+            {
+                this->check_write(fd);
+                auto callback = [&](size_t i) {
+                    this->check_write(fd);
+                    handler(i);
+                };
+                return this->pipe_[write_side(fd)].write_some(first, count, callback);
+            }
+
+            //对端关闭写入且数据已读完时返回 0
+            template <typename OutputIt, typename Handler = wait::yield_t>
+            size_t read_some(bool fd, OutputIt result, size_t count, Handler &&handler = Handler())
+            {
+                auto callback = [&](size_t i) {
+                    this->check_read(fd, 1);
+                    handler(i);
+                };
+
+                try
+                {
+                    this->check_read(fd, 0);
+                    return this->pipe_[read_side(fd)].read_some(result, count, callback);
+                }
+                catch (const end_of_stream &)
+                {
+                    return 0;
+                }
+            }
+
+            template <typename InputIt, typename Handler = wait::yield_t>
+            size_t write(bool fd, InputIt first, size_t count, Handler &&handler = Handler())
+            {
+                this->check_write(fd);
                 auto callback = [&](size_t i) {
-                    if (this->status_ == DISCONNECTED)
-                        throw std::runtime_error("The peer is disconnected");
+                    this->check_write(fd);
                     handler(i);
                 };
-                return this->pipe_[fd ? 0 : 1].write_some(first, count, callback);
+
+                return this->pipe_[write_side(fd)].write(first, count, callback);
             }
 
-            template <typename OutputIt>
-            size_t read_some(bool fd, OutputIt result, size_t count, const wait::handler_t &handler = wait::yield)
+            //对端关闭写入且剩余数据不足 count 时抛出 end_of_stream
+            template <typename OutputIt, typename Handler = wait::yield_t>
+            size_t read(bool fd, OutputIt result, size_t count, Handler &&handler = Handler())
             {
+                this->check_read(fd, 0);
                 auto callback = [&](size_t i) {
-                    if (this->status_ == DISCONNECTED)
-                        throw std::runtime_error("The peer is disconnected");
+                    this->check_read(fd, count);
                     handler(i);
                 };
-                return this->pipe_[fd ? 1 : 0].read_some(result, count, callback);
+
+                return this->pipe_[read_side(fd)].read(result, count, callback);
             }
 
-            template <typename InputIt>
-            size_t write(bool fd, InputIt first, size_t count, const wait::handler_t &handler = wait::yield)
+            //聚集写, 整条记录一次发布
+            template <typename BufferIt, typename Handler = wait::yield_t>
+            size_t write_v(bool fd, BufferIt first, BufferIt last, Handler &&handler = Handler())
             {
+                this->check_write(fd);
                 auto callback = [&](size_t i) {
-                    if (this->status_ == DISCONNECTED)
-                        throw std::runtime_error("The peer is disconnected");
+                    this->check_write(fd);
                     handler(i);
                 };
 
-                return this->pipe_[fd ? 0 : 1].write(first, count, callback);
+                return this->pipe_[write_side(fd)].write_v(first, last, callback);
             }
 
-            template <typename OutputIt>
-            size_t read(bool fd, OutputIt result, size_t count, const wait::handler_t &handler = wait::yield)
+            //分散读
+            template <typename BufferIt, typename Handler = wait::yield_t>
+            size_t read_v(bool fd, BufferIt first, BufferIt last, Handler &&handler = Handler())
             {
+                size_t count = 0;
+                for (auto it = first; it != last; ++it)
+                    count += it->size;
+
+                this->check_read(fd, 0);
                 auto callback = [&](size_t i) {
-                    if (this->status_ == DISCONNECTED)
-                        throw std::runtime_error("The peer is disconnected");
+                    this->check_read(fd, std::min(count, this->pipe_[read_side(fd)].max_size()));
                     handler(i);
                 };
 
-                return this->pipe_[fd ? 1 : 0].read(result, count, callback);
+                return this->pipe_[read_side(fd)].read_v(first, last, callback);
+            }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用
+            Event &readable_event(bool fd)
+            {
+                return this->pipe_[read_side(fd)].readable_event();
             }
 
-            void close()
+            Event &writable_event(bool fd)
             {
-                status_ = DISCONNECTED;
+                return this->pipe_[write_side(fd)].writable_event();
+            }
+
+            //关闭 fd 一端的读取 写入 或两者, 另一方向不受影响
+            //关闭写入后 对端读完剩余数据再得到结束, 关闭读取后 对端写入立即失败
+            void shutdown(bool fd, uint8_t how)
+            {
+                if (how & SHUT_WRITE)
+                {
+                    this->state_[write_side(fd)] |= WRITER_CLOSED;
+                    this->pipe_[write_side(fd)].readable_event().notify();
+                    this->pipe_[write_side(fd)].writable_event().notify();
+                }
+
+                if (how & SHUT_READ)
+                {
+                    this->state_[read_side(fd)] |= READER_CLOSED;
+                    this->pipe_[read_side(fd)].readable_event().notify();
+                    this->pipe_[read_side(fd)].writable_event().notify();
+                }
+            }
+
+            //返回 true 时对端已经关闭, 由后关闭的一端释放通道
+            bool close()
+            {
+                bool closed = status_.exchange(DISCONNECTED) == DISCONNECTED;
+
+                //唤醒阻塞的对端
+                for (auto &pipe : this->pipe_)
+                {
+                    pipe.readable_event().notify();
+                    pipe.writable_event().notify();
+                }
+
+                return closed;
             }
 
             uint8_t get_status()
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "mio/parallelism/utility.hpp"
+#include "mio/parallelism/detail/ring_index.hpp"
 
 #include <stddef.h>
 #include <memory>
@@ -11,19 +12,31 @@ namespace mio
     {
         namespace detail
         {
-            template <typename T, typename Allocator = std::allocator<T>>
+            template <typename T, typename Allocator = std::allocator<T>, size_t N_ = dynamic_extent, typename Layout = layout::padded>
             class ring_buffer
             {
             private:
+                //每条缓存行容纳的槽位数
+                static constexpr size_t LINE_SLOTS = Layout::template line_slots<T>;
+
                 struct alignas(CACHE_LINE) alignas_t
                 {
-                    T value;
+                    T value[LINE_SLOTS];
                 };
 
                 using allocator_traits = typename std::allocator_traits<Allocator>::template rebind_traits<alignas_t>;
 
                 using pointer = typename allocator_traits::pointer;
 
+                //容量向上取整到 LINE_SLOTS 的倍数
+                static constexpr size_t round_size(size_t max_size)
+                {
+                    return (max_size + LINE_SLOTS - 1) / LINE_SLOTS * LINE_SLOTS;
+                }
+
+                static constexpr size_t STATIC_SIZE = N_ == dynamic_extent ? dynamic_extent : round_size(N_);
+                static constexpr size_t STATIC_LINES = N_ == dynamic_extent ? dynamic_extent : STATIC_SIZE / LINE_SLOTS;
+
             public:
                 using value_type = T;
 
@@ -32,48 +45,74 @@ namespace mio
                 using size_type = typename allocator_traits::size_type;
 
             private:
-                alignas(CACHE_LINE) const size_type max_size_;
+                alignas(CACHE_LINE) const ring_index<STATIC_SIZE> index_;
+                const ring_index<STATIC_LINES> line_index_;
 
                 allocator_type allocator_;
 
                 alignas(CACHE_LINE) pointer data_;
 
-                size_type get_index(size_type index) const
+                //相邻下标依次落在不同的缓存行 第 i 个槽位位于 (i % 行数) 行 (i / 行数) 列
+                value_type &at(size_type index) const
                 {
-                    return index % this->max_size();
+                    if constexpr (LINE_SLOTS == 1)
+                    {
+                        return this->data_[get_index(index)].value[0];
+                    }
+                    else
+                    {
+                        size_type i = get_index(index);
+                        return this->data_[line_index_.get_index(i)].value[line_index_.get_lap(i)];
+                    }
                 }
 
             public:
+                ring_buffer()
+                    : ring_buffer(N_)
+                {
+                    static_assert(N_ != dynamic_extent, "a runtime sized ring_buffer needs max_size");
+                }
+
                 ring_buffer(size_type max_size)
-                    : max_size_(max_size)
+                    : index_(round_size(max_size)), line_index_(round_size(max_size) / LINE_SLOTS)
                 {
-                    this->data_ = allocator_traits::allocate(allocator_, max_size);
+                    this->data_ = allocator_traits::allocate(allocator_, this->line_index_.max_size());
                 }
 
                 ring_buffer(size_type max_size, const Allocator &alloc)
-                    : max_size_(max_size), allocator_(alloc)
+                    : index_(round_size(max_size)), line_index_(round_size(max_size) / LINE_SLOTS), allocator_(alloc)
                 {
-                    this->data_ = allocator_traits::allocate(allocator_, max_size);
+                    this->data_ = allocator_traits::allocate(allocator_, this->line_index_.max_size());
                 }
 
                 ~ring_buffer()
                 {
-                    allocator_traits::deallocate(allocator_, this->data_, this->max_size());
+                    allocator_traits::deallocate(allocator_, this->data_, this->line_index_.max_size());
                 }
 
                 value_type &operator[](size_type index)
                 {
-                    return this->data_[get_index(index)].value;
+                    return this->at(index);
                 }
 
                 const value_type &operator[](size_type index) const
                 {
-                    return this->data_[get_index(index)].value;
+                    return this->at(index);
+                }
+
+                size_type get_index(size_type index) const
+                {
+                    return this->index_.get_index(index);
+                }
+
+                size_type get_lap(size_type index) const
+                {
+                    return this->index_.get_lap(index);
                 }
 
                 size_type max_size() const
                 {
-                    return this->max_size_;
+                    return this->index_.max_size();
                 }
             };
         } // namespace detail
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "mio/parallelism/utility.hpp"
+
+#include <stddef.h>
+
+namespace mio
+{
+    namespace parallelism
+    {
+        namespace detail
+        {
+            //环形下标计算, 容量在编译期确定 除法与取模交由编译器折叠
+            template <size_t N_ = dynamic_extent>
+            class ring_index
+            {
+                static_assert(N_ != 0, "ring capacity must not be zero");
+
+            public:
+                using size_type = size_t;
+
+                constexpr ring_index() = default;
+
+                constexpr ring_index(size_type)
+                {
+                }
+
+                static constexpr size_type max_size()
+                {
+                    return N_;
+                }
+
+                //槽位下标
+                static constexpr size_type get_index(size_type index)
+                {
+                    return index % N_;
+                }
+
+                //圈数
+                static constexpr size_type get_lap(size_type index)
+                {
+                    return index / N_;
+                }
+            };
+
+            //容量在构造时确定 若为 2 的幂则用掩码与移位代替取模与除法
+            template <>
+            class ring_index<dynamic_extent>
+            {
+            public:
+                using size_type = size_t;
+
+            private:
+                size_type max_size_;
+                size_type mask_;
+                size_type shift_;
+                bool pow2_;
+
+            public:
+                ring_index(size_type max_size)
+                    : max_size_(max_size), mask_(max_size - 1), shift_(0), pow2_(max_size && !(max_size & (max_size - 1)))
+                {
+                    while (pow2_ && (size_type(1) << shift_) < max_size)
+                        ++shift_;
+                }
+
+                size_type max_size() const
+                {
+                    return max_size_;
+                }
+
+                size_type get_index(size_type index) const
+                {
+                    return pow2_ ? index & mask_ : index % max_size_;
+                }
+
+                size_type get_lap(size_type index) const
+                {
+                    return pow2_ ? index >> shift_ : index / max_size_;
+                }
+            };
+        } // namespace detail
+    }     // namespace parallelism
+} // namespace mio
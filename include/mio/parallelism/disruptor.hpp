@@ -1,91 +1,197 @@
 #pragma once
 
 #include "mio/parallelism/detail/ring_buffer.hpp"
+#include "mio/parallelism/wait.hpp"
 
 #include <stdint.h>
+#include <assert.h>
 
 #include <atomic>
 #include <thread>
-#include <list>
-#include <shared_mutex>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <initializer_list>
 
 namespace mio
 {
     namespace parallelism
     {
-        template <typename T_, size_t SIZE_ = 4096>
+        template <typename T_, size_t SIZE_ = 4096, size_t READER_NUM_ = 64, typename Event = wait::null_event>
         class disruptor
         {
+        private:
+            //读者发布自己的读取序号, 每个序号独占一条缓存行
+            //refs 为读者自身与以它为上游的读者数, 归零时才释放, 避免被复用后下游失去限制
+            struct alignas(CACHE_LINE) gate
+            {
+                std::atomic<size_t> sequence;
+                std::atomic<size_t> refs;
+            };
+
+            //空闲的 gate
+            static constexpr size_t FREE = SIZE_MAX;
+
         public:
             class alignas(64) reader
             {
             private:
                 friend disruptor;
                 disruptor *disruptor_;
-                typename std::list<reader *>::iterator this_it_;
+                gate *gate_;
+
+                //只有本读者修改, 发布到 gate_
+                size_t limit_;
 
-                std::atomic<size_t> limit_ = 0;
+                //上游读者的 gate, 以及缓存的上游最小序号
+                std::vector<gate *> upstream_;
+                size_t upstream_cache_;
 
-                reader(disruptor *disruptor, typename std::list<reader *>::iterator &this_it) : disruptor_(disruptor), this_it_(this_it)
+                reader(disruptor *disruptor, gate *self, std::vector<gate *> &&upstream)
+                    : disruptor_(disruptor), gate_(self), upstream_(std::move(upstream))
                 {
-                    this->limit_ = this->disruptor_->writable_limit_.load();
+                    this->limit_ = this->gate_->sequence;
+                    this->upstream_cache_ = this->upstream_.empty() ? FREE : this->limit_;
                 }
 
-            public:
-                void pull(T_ &ret)
+                //sequence 已被生产者发布 并且所有上游读者都已处理过
+                bool readable(size_t sequence)
                 {
-                    //等待数据可读
-                    while (disruptor_->readable_flag_[this->limit_] != (limit_ / SIZE_) + 1)
-                        std::this_thread::yield();
+                    if (disruptor_->readable_flag_[sequence] != (sequence / SIZE_) + 1)
+                        return false;
 
-                    ret = disruptor_->buffer_[this->limit_];
-                    limit_.fetch_add(1);
+                    if (sequence < this->upstream_cache_)
+                        return true;
+
+                    //只有在缓存显示不可读时才重新计算上游最小序号
+                    size_t min = FREE;
+                    for (auto gate : this->upstream_)
+                        min = std::min(min, gate->sequence.load(std::memory_order_acquire));
+
+                    this->upstream_cache_ = min;
+                    return sequence < min;
+                }
+
+            public:
+                template <typename Handler = wait::yield_t>
+                void pull(T_ &ret, Handler &&handler = Handler())
+                {
+                    ret = this->peek(handler);
+                    this->commit();
                 }
 
                 bool try_pull(T_ &ret)
                 {
-                    //等待数据可读
-                    while (disruptor_->readable_flag_[this->limit_] != (limit_ / SIZE_) + 1)
+                    if (!this->readable(this->limit_))
                         return false;
 
                     ret = disruptor_->buffer_[this->limit_];
-                    limit_.fetch_add(1);
+                    this->commit();
                     return true;
                 }
 
+                //等待下一项可读 并原地访问, 处理完后调用 commit
+                //在 commit 之前对数据的修改 对下游读者可见
+                template <typename Handler = wait::yield_t>
+                T_ &peek(Handler &&handler = Handler())
+                {
+                    //等待数据可读
+                    for (size_t i = 0; !this->readable(this->limit_); i++)
+                        handler(i);
+
+                    return disruptor_->buffer_[this->limit_];
+                }
+
+                //推进 count 项
+                void commit(size_t count = 1)
+                {
+                    limit_ += count;
+                    gate_->sequence.store(limit_, std::memory_order_release);
+                    disruptor_->writable_event_.notify();
+                }
+
+                //从当前位置起连续可读的数量, 至多 max 个
+                size_t available(size_t max = SIZE_)
+                {
+                    size_t count = 0;
+                    max = std::min(max, SIZE_);
+                    while (count < max && this->readable(this->limit_ + count))
+                        count++;
+
+                    return count;
+                }
+
+                //一次读取至多 max 个连续可读的数据, 读者序号只推进一次, 返回读取的数量
+                template <typename OutputIt, typename Handler = wait::yield_t>
+                size_t pull_batch(OutputIt result, size_t max, Handler &&handler = Handler())
+                {
+                    size_t count = 0;
+
+                    //等待数据可读
+                    for (size_t i = 0; max && !(count = this->available(max)); i++)
+                        handler(i);
+
+                    for (size_t n = 0; n < count; n++, ++result)
+                        *result = disruptor_->buffer_[this->limit_ + n];
+
+                    this->commit(count);
+                    return count;
+                }
+
+                //上游先于下游销毁时 其序号停在原处, 下游与生产者都会停在该位置
                 ~reader()
                 {
-                    disruptor_->mutex_.lock();
-                    disruptor_->reader_list_.erase(this_it_);
-                    disruptor_->mutex_.unlock();
+                    assert(this->gate_->refs.load() == 1 && "an upstream reader must outlive its dependents");
+
+                    disruptor_->release(this->gate_);
+                    for (auto gate : this->upstream_)
+                        disruptor_->release(gate);
                 }
             };
 
         private:
             friend reader;
 
-            detail::ring_buffer<T_, SIZE_> buffer_;
-            detail::ring_buffer<std::atomic<size_t>, SIZE_> readable_flag_;
+            detail::ring_buffer<T_, std::allocator<T_>, SIZE_> buffer_;
+            detail::ring_buffer<std::atomic<size_t>, std::allocator<std::atomic<size_t>>, SIZE_> readable_flag_;
 
             alignas(64) std::atomic<size_t> writable_limit_ = 0;
 
-            std::shared_mutex mutex_;
-            std::list<reader *> reader_list_;
+            //缓存的最小读者序号, 只有在看起来已满时才重新计算
+            alignas(CACHE_LINE) std::atomic<size_t> gating_cache_ = 0;
+
+            //可读可写的事件, Event 为 wait::event 时可以阻塞等待
+            alignas(CACHE_LINE) Event readable_event_;
+            Event writable_event_;
+
+            //曾经使用过的 gate 数量, 只增不减
+            alignas(CACHE_LINE) std::atomic<size_t> gate_num_ = 0;
+            gate gate_[READER_NUM_];
 
-            bool min_index(size_t index)
+            //释放一个引用, 最后一个引用释放时 gate 才可以复用
+            void release(gate *gate)
             {
-                this->mutex_.lock_shared();
-                for (auto &it : this->reader_list_)
+                if (gate->refs.fetch_sub(1) == 1)
                 {
-                    if (index >= it->limit_ + SIZE_)
-                    {
-                        this->mutex_.unlock_shared();
-                        return false;
-                    }
+                    gate->sequence = FREE;
+                    this->writable_event_.notify();
                 }
+            }
 
-                this->mutex_.unlock_shared();
-                return true;
+            //index 是否可写
+            bool writable(size_t index)
+            {
+                if (index < this->gating_cache_.load(std::memory_order_acquire) + SIZE_)
+                    return true;
+
+                //重新计算最小读者序号, 没有读者时以 index 为下界
+                size_t min = index;
+                size_t gate_num = this->gate_num_;
+                for (size_t i = 0; i < gate_num; i++)
+                    min = std::min(min, this->gate_[i].sequence.load(std::memory_order_acquire));
+
+                this->gating_cache_.store(min, std::memory_order_release);
+                return index < min + SIZE_;
             }
 
         public:
@@ -95,33 +201,107 @@ namespace mio
                 size_t index = 0;
             };
 
+            //一段连续的序号 [first, first + count)
+            struct range
+            {
+                size_t first;
+                size_t count;
+            };
+
             disruptor()
             {
                 for (size_t i = 0; i < SIZE_; i++)
                 {
                     readable_flag_[i] = 0;
                 }
+
+                for (auto &gate : this->gate_)
+                {
+                    gate.sequence = FREE;
+                    gate.refs = 0;
+                }
             }
 
-            reader *make_reader()
+            //无锁注册读者
+            //没有上游时 读者从当前写入位置开始读取
+            //指定上游时 读者只读取所有上游都已处理过的数据, 从上游的最小位置开始
+            //上游读者必须比它活得更久, 上游的 gate 在所有下游销毁前不会被复用
+            reader *make_reader(std::initializer_list<const reader *> upstream = {})
             {
-                this->mutex_.lock();
-                this->reader_list_.push_back(NULL);
-                this->reader_list_.back() = new reader(this, --this->reader_list_.end());
-                this->mutex_.unlock();
-                return this->reader_list_.back();
+                std::vector<gate *> upstream_gate;
+                for (auto it : upstream)
+                {
+                    it->gate_->refs.fetch_add(1);
+                    upstream_gate.push_back(it->gate_);
+                }
+
+                for (size_t i = 0; i < READER_NUM_; i++)
+                {
+                    //先以缓存的最小序号占位 保证占位期间生产者不会越过它
+                    size_t exp = FREE;
+                    if (!this->gate_[i].sequence.compare_exchange_strong(exp, this->gating_cache_.load()))
+                        continue;
+
+                    size_t gate_num = this->gate_num_;
+                    while (gate_num < i + 1 && !this->gate_num_.compare_exchange_weak(gate_num, i + 1))
+                        ;
+
+                    size_t start = this->writable_limit_.load();
+                    for (auto gate : upstream_gate)
+                        start = std::min(start, gate->sequence.load());
+
+                    this->gate_[i].refs = 1;
+                    this->gate_[i].sequence = start;
+                    return new reader(this, &this->gate_[i], std::move(upstream_gate));
+                }
+
+                for (auto gate : upstream_gate)
+                    gate->refs.fetch_sub(1);
+
+                throw std::runtime_error("Too many disruptor readers");
             }
 
-            void push(const T_ &val)
+            template <typename Handler = wait::yield_t>
+            void push(const T_ &val, Handler &&handler = Handler())
             {
                 size_t index = this->writable_limit_.fetch_add(1);
 
                 //等待可写
-                while (!this->min_index(index))
-                    std::this_thread::yield();
+                for (size_t i = 0; !this->writable(index); i++)
+                    handler(i);
 
                 this->buffer_[index] = val;
                 this->readable_flag_[index] = (index / SIZE_) + 1;
+                this->readable_event_.notify();
+            }
+
+            //一次领取 count 个连续槽位, count 不能超过 SIZE_
+            //通过 operator[] 填充后 调用 publish 发布
+            template <typename Handler = wait::yield_t>
+            range claim(size_t count, Handler &&handler = Handler())
+            {
+                size_t index = this->writable_limit_.fetch_add(count);
+
+                //等待最后一个槽位可写
+                for (size_t i = 0; count && !this->writable(index + count - 1); i++)
+                    handler(i);
+
+                return range{index, count};
+            }
+
+            //访问已领取的槽位
+            T_ &operator[](size_t sequence)
+            {
+                return this->buffer_[sequence];
+            }
+
+            //发布已领取并填充的槽位, 只通知一次
+            void publish(const range &range)
+            {
+                for (size_t index = range.first; index < range.first + range.count; index++)
+                    this->readable_flag_[index] = (index / SIZE_) + 1;
+
+                this->readable_event_.notify();
             }
 
             bool try_push(const T_ &val, context &context)
@@ -132,22 +312,34 @@ namespace mio
 
                 if (flag == true)
                 {
-                    index = this->writable_limit.fetch_add(1);
+                    index = this->writable_limit_.fetch_add(1);
                 }
 
                 //等待可写
-                if (!this->min_index(index))
+                if (!this->writable(index))
                 {
                     flag = false;
                     return false;
                 }
 
-                this->buffer[index] = val;
-                this->readable_flag[index] = (index / SIZE_) + 1;
+                this->buffer_[index] = val;
+                this->readable_flag_[index] = (index / SIZE_) + 1;
+                this->readable_event_.notify();
 
                 flag = true;
                 return true;
             }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用, 读者阻塞在 readable_event 上, 写者阻塞在 writable_event 上
+            Event &readable_event()
+            {
+                return this->readable_event_;
+            }
+
+            Event &writable_event()
+            {
+                return this->writable_event_;
+            }
         };
     } // namespace parallelism
 } // namespace mio
@@ -0,0 +1,246 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "mio/parallelism/utility.hpp"
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //基于纪元的回收域, 与 hazard_domain 接口相同, 可互相替换
+        //读者进入时发布当前的全局纪元, 退出时清除, 期间访问的节点都不会被释放
+        //退休的指针记下退休时的纪元, 所有活跃读者都已见到新纪元后推进全局纪元, 推进两次后释放
+        //进入与退出只写自己的记录, 代价远低于风险指针, 但一个停滞的读者会阻止所有回收
+        //编号小于 RECORD_NUM_ 的线程独占自己的记录, 其余线程使用追加的记录
+        template <size_t RECORD_NUM_ = 64>
+        class epoch_domain
+        {
+        public:
+            using deleter_t = void (*)(void *ptr, void *context);
+
+            //积累到 RETIRE_NUM 个退休指针时 尝试推进纪元并批量释放
+            static constexpr size_t RETIRE_NUM = RECORD_NUM_ * 2;
+
+        private:
+            struct retired
+            {
+                void *ptr;
+                deleter_t deleter;
+                void *context;
+                uint64_t epoch;
+            };
+
+            struct alignas(CACHE_LINE) record
+            {
+                //读者进入时的纪元, 0 表示不在读区间内
+                std::atomic<uint64_t> epoch = 0;
+
+                //以下只由持有记录的线程访问
+                size_t nest = 0;
+                std::vector<retired> retired_list;
+
+                //下次回收的阈值, 纪元无法推进时翻倍 避免每次退休都扫描
+                size_t collect_limit = RETIRE_NUM;
+
+                //追加的记录使用
+                std::atomic<bool> busy = false;
+                record *next = nullptr;
+            };
+
+            //全局纪元, 从 1 开始
+            alignas(CACHE_LINE) std::atomic<uint64_t> epoch_ = 1;
+
+            record records_[RECORD_NUM_];
+
+            //追加的记录, 只增不减, 析构时释放
+            std::atomic<record *> overflow_ = nullptr;
+
+            static bool try_acquire(record &r)
+            {
+                return !r.busy.load(std::memory_order_relaxed) && !r.busy.exchange(true, std::memory_order_acquire);
+            }
+
+            //遍历所有记录
+            template <typename Function>
+            void for_each(Function &&function)
+            {
+                for (auto &r : records_)
+                    function(r);
+
+                for (record *r = overflow_.load(std::memory_order_acquire); r; r = r->next)
+                    function(*r);
+            }
+
+            record *acquire()
+            {
+                size_t index = thread_index();
+                if (index < RECORD_NUM_)
+                    return &records_[index];
+
+                for (record *r = overflow_.load(std::memory_order_acquire); r; r = r->next)
+                {
+                    if (try_acquire(*r))
+                        return r;
+                }
+
+                record *r = new record;
+                r->busy = true;
+                r->next = overflow_.load(std::memory_order_relaxed);
+                while (!overflow_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+                    ;
+
+                return r;
+            }
+
+            void release(record *r)
+            {
+                if (r < records_ || r >= records_ + RECORD_NUM_)
+                    r->busy.store(false, std::memory_order_release);
+            }
+
+            void enter(record *r)
+            {
+                if (r->nest++)
+                    return;
+
+                r->epoch.store(epoch_.load(std::memory_order_acquire), std::memory_order_relaxed);
+
+                //发布纪元后 才能读取共享的指针
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+            void exit(record *r)
+            {
+                if (--r->nest)
+                    return;
+
+                r->epoch.store(0, std::memory_order_release);
+            }
+
+            //所有活跃读者都处于当前纪元时 推进一次
+            void try_advance()
+            {
+                uint64_t epoch = epoch_.load(std::memory_order_acquire);
+
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                bool quiescent = true;
+                this->for_each([&](record &rec) {
+                    uint64_t e = rec.epoch.load(std::memory_order_acquire);
+                    if (e && e != epoch)
+                        quiescent = false;
+                });
+
+                if (quiescent)
+                    epoch_.compare_exchange_strong(epoch, epoch + 1);
+            }
+
+            //释放 r 上所有退休后已经过两个纪元的指针
+            void collect(record *r)
+            {
+                this->try_advance();
+                uint64_t epoch = epoch_.load(std::memory_order_acquire);
+
+                auto &list = r->retired_list;
+                size_t n = 0;
+                for (size_t i = 0; i < list.size(); i++)
+                {
+                    if (list[i].epoch + 2 > epoch)
+                        list[n++] = list[i];
+                    else
+                        list[i].deleter(list[i].ptr, list[i].context);
+                }
+
+                list.resize(n);
+                r->collect_limit = std::max(RETIRE_NUM, n * 2);
+            }
+
+        public:
+            //读区间, 可以嵌套
+            class guard
+            {
+            private:
+                epoch_domain *domain_;
+                record *record_;
+
+            public:
+                explicit guard(epoch_domain &domain)
+                    : domain_(&domain), record_(domain.acquire())
+                {
+                    domain_->enter(record_);
+                }
+
+                guard(const guard &) = delete;
+                guard &operator=(const guard &) = delete;
+
+                ~guard()
+                {
+                    domain_->exit(record_);
+                    domain_->release(record_);
+                }
+
+                //读区间内读到的指针都受保护, index 只为与 hazard_domain 保持一致
+                template <typename T>
+                T *protect(size_t, const std::atomic<T *> &src)
+                {
+                    return src.load(std::memory_order_acquire);
+                }
+
+                void set(size_t, void *)
+                {
+                }
+
+                void reset(size_t)
+                {
+                }
+
+                //ptr 已从结构中移除, 待所有读者离开当前纪元后 调用 deleter(ptr, context)
+                void retire(void *ptr, deleter_t deleter, void *context)
+                {
+                    //移除 ptr 的写入先于读取纪元
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                    auto &list = record_->retired_list;
+                    list.push_back(retired{ptr, deleter, context, domain_->epoch_.load(std::memory_order_acquire)});
+
+                    if (list.size() >= record_->collect_limit)
+                        domain_->collect(record_);
+                }
+            };
+
+            epoch_domain() = default;
+
+            epoch_domain(const epoch_domain &) = delete;
+            epoch_domain &operator=(const epoch_domain &) = delete;
+
+            //此时不应再有线程访问, 释放所有退休的指针
+            ~epoch_domain()
+            {
+                this->for_each([](record &rec) {
+                    for (auto &r : rec.retired_list)
+                        r.deleter(r.ptr, r.context);
+                });
+
+                record *r = overflow_;
+                while (r)
+                {
+                    record *next = r->next;
+                    delete r;
+                    r = next;
+                }
+            }
+
+            //进程内共享的默认域, 退休对象的 deleter 不依赖其他对象的生命周期时使用
+            static epoch_domain &instance()
+            {
+                static epoch_domain domain;
+                return domain;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <functional>
+
+#include "mio/parallelism/epoch_domain.hpp"
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //无锁哈希表, 分裂序链表 (split-ordered list)
+        //所有节点在一条按哈希值位反转排序的无锁链表上, 每个桶是链表中的一个哨兵节点
+        //桶数翻倍时只需插入新的哨兵, 已有节点不移动
+        //删除先在 next 上打标记再摘除, 摘除的节点与被替换的值交给回收域
+        //Domain 为 hazard_domain 时至少需要 3 个风险指针
+        template <typename Key, typename Value,
+                  typename Hash = std::hash<Key>,
+                  typename KeyEqual = std::equal_to<Key>,
+                  typename Domain = epoch_domain<>>
+        class hash_map
+        {
+        private:
+            using guard_t = typename Domain::guard;
+
+            //平均每个桶的节点数超过 LOAD_FACTOR 时桶数翻倍
+            static constexpr size_t LOAD_FACTOR = 2;
+
+            //第 0 段 1 个桶, 第 i 段 2^(i-1) 个桶, 按需分配
+            static constexpr size_t SEGMENT_NUM = 64;
+
+            struct node
+            {
+                //最低位为删除标记
+                std::atomic<node *> next;
+
+                //位反转后的哈希值, 哨兵为偶数 数据节点为奇数
+                const uint64_t order;
+
+                node(uint64_t order)
+                    : next(nullptr), order(order)
+                {
+                }
+            };
+
+            struct entry : node
+            {
+                const Key key;
+                std::atomic<Value *> value;
+
+                entry(uint64_t order, const Key &key, Value *value)
+                    : node(order), key(key), value(value)
+                {
+                }
+
+                ~entry()
+                {
+                    delete value.load();
+                }
+            };
+
+            Domain domain_;
+
+            Hash hash_;
+            KeyEqual key_equal_;
+
+            alignas(CACHE_LINE) std::atomic<std::atomic<node *> *> segments_[SEGMENT_NUM];
+
+            alignas(CACHE_LINE) std::atomic<size_t> bucket_count_;
+            alignas(CACHE_LINE) std::atomic<size_t> size_;
+
+            static node *marked(node *p)
+            {
+                return reinterpret_cast<node *>(reinterpret_cast<uintptr_t>(p) | 1);
+            }
+
+            static node *unmarked(node *p)
+            {
+                return reinterpret_cast<node *>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1));
+            }
+
+            static bool is_marked(node *p)
+            {
+                return reinterpret_cast<uintptr_t>(p) & 1;
+            }
+
+            static uint64_t reverse(uint64_t x)
+            {
+                x = ((x >> 1) & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+                x = ((x >> 2) & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+                x = ((x >> 4) & 0x0F0F0F0F0F0F0F0F) | ((x & 0x0F0F0F0F0F0F0F0F) << 4);
+                return __builtin_bswap64(x);
+            }
+
+            static uint64_t regular_order(size_t hash)
+            {
+                return reverse(uint64_t(hash) | (uint64_t(1) << 63));
+            }
+
+            static uint64_t dummy_order(size_t bucket)
+            {
+                return reverse(bucket);
+            }
+
+            static void reclaim(void *ptr, void *)
+            {
+                delete static_cast<entry *>(ptr);
+            }
+
+            static void reclaim_value(void *ptr, void *)
+            {
+                delete static_cast<Value *>(ptr);
+            }
+
+            //桶在段中的位置, 段不存在时分配
+            std::atomic<node *> &get_slot(size_t bucket)
+            {
+                size_t segment = bucket ? 64 - __builtin_clzll(bucket) : 0;
+                size_t base = segment ? size_t(1) << (segment - 1) : 0;
+                size_t size = segment ? base : 1;
+
+                std::atomic<node *> *slots = segments_[segment].load(std::memory_order_acquire);
+                if (!slots)
+                {
+                    std::atomic<node *> *exp = nullptr;
+                    slots = new std::atomic<node *>[size];
+                    for (size_t i = 0; i < size; i++)
+                        slots[i].store(nullptr, std::memory_order_relaxed);
+
+                    if (!segments_[segment].compare_exchange_strong(exp, slots))
+                    {
+                        delete[] slots;
+                        slots = exp;
+                    }
+                }
+
+                return slots[bucket - base];
+            }
+
+            //桶的哨兵, 尚未初始化时从父桶插入, 哨兵不会被删除 不需要保护
+            node *get_bucket(size_t bucket, guard_t &guard)
+            {
+                std::atomic<node *> &slot = this->get_slot(bucket);
+
+                node *dummy = slot.load(std::memory_order_acquire);
+                if (dummy)
+                    return dummy;
+
+                //父桶为去掉最高位的桶
+                size_t parent = bucket & ~(size_t(1) << (63 - __builtin_clzll(bucket)));
+                node *head = this->get_bucket(parent, guard);
+
+                dummy = new node(dummy_order(bucket));
+                std::atomic<node *> *prev;
+                node *cur;
+                while (1)
+                {
+                    if (this->search(head, dummy->order, nullptr, guard, prev, cur))
+                    {
+                        //其他线程已经插入
+                        delete dummy;
+                        dummy = cur;
+                        break;
+                    }
+
+                    dummy->next.store(cur, std::memory_order_relaxed);
+                    if (prev->compare_exchange_strong(cur, dummy))
+                        break;
+                }
+
+                slot.store(dummy, std::memory_order_release);
+                return dummy;
+            }
+
+            node *get_head(size_t hash, guard_t &guard)
+            {
+                return this->get_bucket(hash & (bucket_count_.load(std::memory_order_acquire) - 1), guard);
+            }
+
+            //从 head 开始查找 order 与 key 相同的节点, key 为空时查找哨兵
+            //返回时 *prev == cur, cur 为第一个不小于目标的节点, prev 所在节点与 cur 受 0 1 号风险指针保护
+            //沿途摘除已标记删除的节点
+            bool search(node *head, uint64_t order, const Key *key, guard_t &guard, std::atomic<node *> *&prev, node *&cur)
+            {
+            retry:
+                size_t hp = 0, hc = 1;
+                prev = &head->next;
+                cur = prev->load(std::memory_order_acquire);
+
+                while (1)
+                {
+                    if (!cur)
+                        return false;
+
+                    //发布后确认 cur 仍可从 prev 到达
+                    guard.set(hc, cur);
+                    if (prev->load() != cur)
+                        goto retry;
+
+                    node *next = cur->next.load(std::memory_order_acquire);
+                    if (is_marked(next))
+                    {
+                        node *exp = cur;
+                        if (!prev->compare_exchange_strong(exp, unmarked(next)))
+                            goto retry;
+
+                        guard.retire(cur, &hash_map::reclaim, nullptr);
+                        cur = unmarked(next);
+                        continue;
+                    }
+
+                    if (cur->order > order)
+                        return false;
+
+                    if (cur->order == order && (!key || key_equal_(static_cast<entry *>(cur)->key, *key)))
+                        return true;
+
+                    prev = &cur->next;
+                    std::swap(hp, hc);
+                    cur = next;
+                }
+            }
+
+            //节点数超过负载时 桶数翻倍
+            void grow(size_t size)
+            {
+                size_t count = bucket_count_.load(std::memory_order_relaxed);
+                if (size > count * LOAD_FACTOR && count < (size_t(1) << (SEGMENT_NUM - 2)))
+                    bucket_count_.compare_exchange_strong(count, count * 2);
+            }
+
+        public:
+            using key_type = Key;
+            using mapped_type = Value;
+            using size_type = size_t;
+
+            hash_map()
+                : bucket_count_(2), size_(0)
+            {
+                for (auto &segment : segments_)
+                    segment.store(nullptr, std::memory_order_relaxed);
+
+                this->get_slot(0).store(new node(dummy_order(0)), std::memory_order_relaxed);
+            }
+
+            hash_map(const hash_map &) = delete;
+            hash_map &operator=(const hash_map &) = delete;
+
+            //此时不应再有线程访问, 已摘除的节点由回收域释放
+            ~hash_map()
+            {
+                node *n = this->get_slot(0).load();
+                while (n)
+                {
+                    node *next = unmarked(n->next.load());
+                    if (n->order & 1)
+                        delete static_cast<entry *>(n);
+                    else
+                        delete n;
+                    n = next;
+                }
+
+                for (auto &segment : segments_)
+                    delete[] segment.load();
+            }
+
+            //复制出 key 对应的值, 不存在时返回 false
+            bool find(const Key &key, Value &result)
+            {
+                guard_t guard(domain_);
+
+                size_t hash = hash_(key);
+                std::atomic<node *> *prev;
+                node *cur;
+                if (!this->search(this->get_head(hash, guard), regular_order(hash), &key, guard, prev, cur))
+                    return false;
+
+                result = *guard.protect(2, static_cast<entry *>(cur)->value);
+                return true;
+            }
+
+            bool contains(const Key &key)
+            {
+                guard_t guard(domain_);
+
+                size_t hash = hash_(key);
+                std::atomic<node *> *prev;
+                node *cur;
+                return this->search(this->get_head(hash, guard), regular_order(hash), &key, guard, prev, cur);
+            }
+
+            //插入或替换, 插入时返回 true
+            bool insert_or_assign(const Key &key, const Value &value)
+            {
+                guard_t guard(domain_);
+
+                size_t hash = hash_(key);
+                uint64_t order = regular_order(hash);
+                entry *e = nullptr;
+
+                while (1)
+                {
+                    std::atomic<node *> *prev;
+                    node *cur;
+                    if (this->search(this->get_head(hash, guard), order, &key, guard, prev, cur))
+                    {
+                        entry *found = static_cast<entry *>(cur);
+                        guard.retire(found->value.exchange(new Value(value)), &hash_map::reclaim_value, nullptr);
+
+                        //替换时节点已被删除, 新值随节点释放 重新插入
+                        if (!is_marked(found->next.load()))
+                        {
+                            delete e;
+                            return false;
+                        }
+
+                        continue;
+                    }
+
+                    if (!e)
+                        e = new entry(order, key, new Value(value));
+
+                    e->next.store(cur, std::memory_order_relaxed);
+                    if (prev->compare_exchange_strong(cur, e))
+                    {
+                        this->grow(size_.fetch_add(1) + 1);
+                        return true;
+                    }
+                }
+            }
+
+            //删除时返回 true
+            bool erase(const Key &key)
+            {
+                guard_t guard(domain_);
+
+                size_t hash = hash_(key);
+                uint64_t order = regular_order(hash);
+
+                while (1)
+                {
+                    std::atomic<node *> *prev;
+                    node *cur;
+                    node *head = this->get_head(hash, guard);
+                    if (!this->search(head, order, &key, guard, prev, cur))
+                        return false;
+
+                    //先标记 标记成功的线程完成删除
+                    node *next = cur->next.load(std::memory_order_acquire);
+                    if (is_marked(next) || !cur->next.compare_exchange_strong(next, marked(next)))
+                        continue;
+
+                    size_.fetch_sub(1);
+
+                    node *exp = cur;
+                    if (prev->compare_exchange_strong(exp, next))
+                        guard.retire(cur, &hash_map::reclaim, nullptr);
+                    else
+                        this->search(head, order, &key, guard, prev, cur);
+
+                    return true;
+                }
+            }
+
+            size_type size() const
+            {
+                return size_.load(std::memory_order_relaxed);
+            }
+
+            bool empty() const
+            {
+                return !this->size();
+            }
+
+            size_type bucket_count() const
+            {
+                return bucket_count_.load(std::memory_order_relaxed);
+            }
+
+            bool is_lock_free() const
+            {
+                return true;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
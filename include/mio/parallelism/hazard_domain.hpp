@@ -0,0 +1,226 @@
+#pragma once
+
+#include <stddef.h>
+
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "mio/parallelism/utility.hpp"
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //风险指针域
+        //线程在一次操作期间持有一条记录, 用记录中的 HAZARD_NUM_ 个风险指针保护正在访问的节点
+        //每个线程优先使用自己编号对应的记录, 同时持有的记录超过 RECORD_NUM_ 时动态追加, 获取记录不会阻塞
+        //退休的指针挂在记录上, 积累到 RETIRE_NUM 个时扫描所有风险指针, 释放不再被保护的指针
+        template <size_t HAZARD_NUM_ = 2, size_t RECORD_NUM_ = 64>
+        class hazard_domain
+        {
+        public:
+            using deleter_t = void (*)(void *ptr, void *context);
+
+            //扫描的阈值, 与风险指针总数成正比 每次扫描至少能释放一半
+            static constexpr size_t RETIRE_NUM = HAZARD_NUM_ * RECORD_NUM_ * 2;
+
+        private:
+            struct retired
+            {
+                void *ptr;
+                deleter_t deleter;
+                void *context;
+            };
+
+            struct alignas(CACHE_LINE) record
+            {
+                std::atomic<bool> busy = false;
+                std::atomic<void *> hazard[HAZARD_NUM_] = {};
+
+                //只由持有记录的线程访问
+                std::vector<retired> retired_list;
+
+                //追加的记录组成的链表
+                record *next = nullptr;
+            };
+
+            record records_[RECORD_NUM_];
+
+            //追加的记录, 只增不减, 析构时释放
+            std::atomic<record *> overflow_ = nullptr;
+
+            static bool try_acquire(record &r)
+            {
+                return !r.busy.load(std::memory_order_relaxed) && !r.busy.exchange(true, std::memory_order_acquire);
+            }
+
+            //遍历所有记录
+            template <typename Function>
+            void for_each(Function &&function)
+            {
+                for (auto &r : records_)
+                    function(r);
+
+                for (record *r = overflow_.load(std::memory_order_acquire); r; r = r->next)
+                    function(*r);
+            }
+
+            //线程优先使用自己编号对应的记录, 被占用时向后探测, 全部被占用时追加一条
+            record *acquire()
+            {
+                size_t index = thread_index();
+                for (size_t i = 0; i < RECORD_NUM_; i++)
+                {
+                    record &r = records_[(index + i) % RECORD_NUM_];
+                    if (try_acquire(r))
+                        return &r;
+                }
+
+                for (record *r = overflow_.load(std::memory_order_acquire); r; r = r->next)
+                {
+                    if (try_acquire(*r))
+                        return r;
+                }
+
+                record *r = new record;
+                r->busy = true;
+                r->next = overflow_.load(std::memory_order_relaxed);
+                while (!overflow_.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+                    ;
+
+                return r;
+            }
+
+            void release(record *r)
+            {
+                for (auto &hazard : r->hazard)
+                    hazard.store(nullptr, std::memory_order_release);
+
+                r->busy.store(false, std::memory_order_release);
+            }
+
+            //释放 r 上所有不被任何风险指针保护的指针
+            void scan(record *r)
+            {
+                std::vector<void *> hazards;
+                hazards.reserve(HAZARD_NUM_ * RECORD_NUM_);
+
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                this->for_each([&](record &rec) {
+                    for (auto &hazard : rec.hazard)
+                    {
+                        void *ptr = hazard.load(std::memory_order_acquire);
+                        if (ptr)
+                            hazards.push_back(ptr);
+                    }
+                });
+
+                std::sort(hazards.begin(), hazards.end());
+
+                auto &list = r->retired_list;
+                size_t n = 0;
+                for (size_t i = 0; i < list.size(); i++)
+                {
+                    if (std::binary_search(hazards.begin(), hazards.end(), list[i].ptr))
+                        list[n++] = list[i];
+                    else
+                        list[i].deleter(list[i].ptr, list[i].context);
+                }
+
+                list.resize(n);
+            }
+
+        public:
+            //一次操作期间持有的记录
+            class guard
+            {
+            private:
+                hazard_domain *domain_;
+                record *record_;
+
+            public:
+                explicit guard(hazard_domain &domain)
+                    : domain_(&domain), record_(domain.acquire())
+                {
+                }
+
+                guard(const guard &) = delete;
+                guard &operator=(const guard &) = delete;
+
+                ~guard()
+                {
+                    domain_->release(record_);
+                }
+
+                //用第 index 个风险指针保护 src 的当前值
+                template <typename T>
+                T *protect(size_t index, const std::atomic<T *> &src)
+                {
+                    T *ptr = src.load(std::memory_order_relaxed);
+                    while (1)
+                    {
+                        record_->hazard[index].store(ptr, std::memory_order_seq_cst);
+
+                        //发布后再次确认 仍可从 src 到达
+                        T *cur = src.load(std::memory_order_seq_cst);
+                        if (cur == ptr)
+                            return ptr;
+
+                        ptr = cur;
+                    }
+                }
+
+                //直接发布 ptr, 由调用者在之后确认 ptr 仍可到达, 用于带标记位的指针
+                void set(size_t index, void *ptr)
+                {
+                    record_->hazard[index].store(ptr, std::memory_order_seq_cst);
+                }
+
+                void reset(size_t index)
+                {
+                    record_->hazard[index].store(nullptr, std::memory_order_release);
+                }
+
+                //ptr 已从结构中移除, 待没有风险指针保护时 调用 deleter(ptr, context)
+                void retire(void *ptr, deleter_t deleter, void *context)
+                {
+                    auto &list = record_->retired_list;
+                    list.push_back(retired{ptr, deleter, context});
+
+                    if (list.size() >= RETIRE_NUM)
+                        domain_->scan(record_);
+                }
+            };
+
+            hazard_domain() = default;
+
+            hazard_domain(const hazard_domain &) = delete;
+            hazard_domain &operator=(const hazard_domain &) = delete;
+
+            //此时不应再有线程访问, 释放所有退休的指针
+            ~hazard_domain()
+            {
+                this->for_each([](record &rec) {
+                    for (auto &r : rec.retired_list)
+                        r.deleter(r.ptr, r.context);
+                });
+
+                record *r = overflow_;
+                while (r)
+                {
+                    record *next = r->next;
+                    delete r;
+                    r = next;
+                }
+            }
+
+            //进程内共享的默认域, 退休对象的 deleter 不依赖其他对象的生命周期时使用
+            static hazard_domain &instance()
+            {
+                static hazard_domain domain;
+                return domain;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -1,221 +1,91 @@
 #pragma once
 
 #include <stddef.h>
-#include <stdint.h>
 #include <atomic>
+#include <optional>
 
-#include "mio/parallelism/aba_ptr.hpp"
+#include "mio/parallelism/hazard_domain.hpp"
 
 namespace mio
 {
     namespace parallelism
     {
-        template <typename T_, size_t DEL_CHACHE>
+        template <typename T_, typename Domain>
         class ref_ptr;
 
-        template <typename T_, size_t DEL_CHACHE = 100>
+        //可被并发替换的指针, 读者通过 ref_ptr 访问
+        //被替换下来的旧值交给回收域, 没有 ref_ptr 引用时释放
+        //Domain 为 hazard_domain 或 epoch_domain, 后者读取更快 但停滞的读者会阻止回收
+        template <typename T_, typename Domain = hazard_domain<1>>
         class hazard_ptr
         {
         private:
-            friend class ref_ptr<T_, DEL_CHACHE>;
-
-            struct node
-            {
-                T_ *ptr;
-                std::atomic<node *> next;
-                std::atomic<aba_ptr<node>> free;
-                std::atomic<bool> flag;
-            };
+            friend class ref_ptr<T_, Domain>;
 
             std::atomic<T_ *> ptr_;
 
-            node ref_list_;
-
-            node del_list_;
-            std::atomic<uint64_t> del_count_ = 0;
-
-            std::atomic_flag del_flag_ = false;
-
-            void list_push(node &list, node *n)
-            {
-                node *exp = list.next;
-                do
-                {
-                    n->next = exp;
-                } while (!list.next.compare_exchange_weak(exp, n));
-            }
-
-            aba_ptr<node> alloc(node &list)
-            {
-                aba_ptr<node> exp = list.free;
-                aba_ptr<node> ret;
-                do
-                {
-                    //没有可以节点了 就自己分配一个
-                    if (exp == nullptr)
-                    {
-                        ret = new node;
-                        ret->flag = true;
-                        ret->ptr = nullptr;
-                        list_push(list, ret);
-                        return ret;
-                    }
-
-                    ret = exp;
-                } while (!list.free.compare_exchange_weak(exp, exp->free));
-
-                ret->flag = true;
-                return ret;
-            }
+            Domain *domain_;
 
-            void free(node &list, aba_ptr<node> n)
+            static void reclaim(void *ptr, void *)
             {
-                n->ptr = nullptr;
-                n->flag = false;
-                aba_ptr<node> exp = list.free;
-                do
-                {
-                    n->free = exp;
-                } while (!list.free.compare_exchange_weak(exp, n));
+                delete static_cast<T_ *>(ptr);
             }
 
-            //返回一个 ref node
-            node *make_ref_node()
-            {
-                //尝试寻找一个释放的节点
-                node *ret = alloc(ref_list_);
-
-                do
-                {
-                    ret->ptr = ptr_;
-                } while (ret->ptr != ptr_);
-
-                return ret;
-            }
-
-            //删除该指针
-            void del_ptr(T_ *ptr)
+        public:
+            //默认使用进程内共享的域
+            explicit hazard_ptr(T_ *ptr = nullptr, Domain &domain = Domain::instance())
+                : ptr_(ptr), domain_(&domain)
             {
-                //尝试从 free list获取一个
-                node *del = alloc(del_list_);
-                del->ptr = ptr;
-
-                ++del_count_;
-
-                if (del_count_ > DEL_CHACHE && !del_flag_.test_and_set())
-                {
-                    del_count_ = 0;
-                    reclaim();
-                    del_flag_.clear();
-                }
             }
 
-            //释放节点
-            void reclaim()
-            {
-                //存储所有 正在使用的指针
-                std::unordered_set<T_ *> ref_set;
+            hazard_ptr(const hazard_ptr &) = delete;
+            hazard_ptr &operator=(const hazard_ptr &) = delete;
 
-                for (node *n = ref_list_.next; n; n = n->next)
-                {
-                    ref_set.insert(n->ptr);
-                }
-
-                for (node *n = del_list_.next; n; n = n->next)
-                {
-                    if (ref_set.find(n->ptr) == ref_set.end() && n->flag != false)
-                    {
-                        delete n->ptr;
-                        free(del_list_, n);
-                    }
-                    else
-                    {
-                        ++del_count_;
-                    }
-                }
-            }
-
-        public:
-            hazard_ptr()
+            //此时不应再有 ref_ptr 引用
+            ~hazard_ptr()
             {
-                ptr_ = nullptr;
-
-                ref_list_.next = nullptr;
-                ref_list_.free = nullptr;
-
-                del_list_.next = nullptr;
-                del_list_.free = nullptr;
+                delete ptr_.load();
             }
 
-            ~hazard_ptr()
+            hazard_ptr &operator=(T_ *ptr)
             {
-                //释放 ptr
-                delete ptr_;
-
-                //释放所有未释放节点
-                reclaim();
-
-                //清除所有node
-
-                for (node *n = ref_list_.next; n;)
+                T_ *old_ptr = ptr_.exchange(ptr);
+                if (old_ptr)
                 {
-                    node *p = n;
-                    n = n->next;
-                    delete p;
+                    typename Domain::guard guard(*domain_);
+                    guard.retire(old_ptr, &hazard_ptr::reclaim, nullptr);
                 }
 
-                for (node *n = del_list_.next; n;)
-                {
-                    node *p = n;
-                    n = n->next;
-                    delete p;
-                }
-            }
-
-            hazard_ptr &operator=(T_ *ptr)
-            {
-                auto old_ptr = ptr_.exchange(ptr);
-                del_ptr(old_ptr);
                 return *this;
             }
         };
 
-        template <typename T_, size_t DEL_CHACHE = 100>
+        //引用 hazard_ptr 的当前值, 存活期间该值不会被释放
+        template <typename T_, typename Domain = hazard_domain<1>>
         class ref_ptr
         {
         public:
-            using hazard_ptr_t = hazard_ptr<T_, DEL_CHACHE>;
-            using node_t = typename hazard_ptr<T_, DEL_CHACHE>::node;
+            using hazard_ptr_t = hazard_ptr<T_, Domain>;
 
         private:
-            hazard_ptr_t *hazard_ptr_;
-            node_t *ref_node_;
+            std::optional<typename Domain::guard> guard_;
+            T_ *ptr_ = nullptr;
 
         public:
-            ref_ptr()
-            {
-                hazard_ptr_ = nullptr;
-                ref_node_ = nullptr;
-            }
+            ref_ptr() = default;
 
             ref_ptr(hazard_ptr_t &hazard_ptr)
             {
-                hazard_ptr_ = &hazard_ptr;
-                ref_node_ = hazard_ptr_->make_ref_node();
+                guard_.emplace(*hazard_ptr.domain_);
+                ptr_ = guard_->protect(0, hazard_ptr.ptr_);
             }
 
-            ~ref_ptr()
-            {
-                //把节点放到free list中
-                if (ref_node_)
-                {
-                    hazard_ptr_->free(hazard_ptr_->ref_list_, ref_node_);
-                }
-            }
+            ref_ptr(const ref_ptr &) = delete;
+            ref_ptr &operator=(const ref_ptr &) = delete;
 
             T_ *get()
             {
-                return ref_node_->ptr;
+                return ptr_;
             }
 
             T_ &operator*()
@@ -230,4 +100,4 @@ namespace mio
         };
 
     } // namespace parallelism
-} // namespace mio
\ No newline at end of file
+} // namespace mio
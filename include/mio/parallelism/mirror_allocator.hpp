@@ -0,0 +1,121 @@
+#pragma once
+
+#include <stddef.h>
+#include <errno.h>
+
+#include <new>
+#include <type_traits>
+#include <stdexcept>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //把同一块内存在虚拟地址上连续映射两次
+        //[data, data + n) 与 [data + n, data + 2n) 是同一块物理内存
+        //因此环形缓冲区中任意不超过容量的区间 在虚拟地址上都是连续的
+        template <typename T_>
+        class mirror_allocator
+        {
+        public:
+            using value_type = T_;
+            using size_type = size_t;
+            using difference_type = ptrdiff_t;
+
+            static constexpr bool mirrored = true;
+
+            template <typename U>
+            struct rebind
+            {
+                using other = mirror_allocator<U>;
+            };
+
+            mirror_allocator() = default;
+
+            template <typename U>
+            mirror_allocator(const mirror_allocator<U> &)
+            {
+            }
+
+            //映射以页为单位, 把 n 个元素向上取整到整页
+            static size_type round_size(size_type n)
+            {
+                size_type page = sysconf(_SC_PAGESIZE);
+                if (page % sizeof(T_))
+                    throw std::invalid_argument("The element size does not divide the page size");
+
+                size_type bytes = (n * sizeof(T_) + page - 1) / page * page;
+                return bytes / sizeof(T_);
+            }
+
+            T_ *allocate(size_type n)
+            {
+                size_type bytes = n * sizeof(T_);
+                if (!bytes || bytes % sysconf(_SC_PAGESIZE))
+                    throw std::invalid_argument("Mirrored memory must be a whole number of pages");
+
+                int fd = memfd_create("mio_mirror", MFD_CLOEXEC);
+                if (fd == -1)
+                    throw std::system_error(errno, std::system_category());
+
+                if (ftruncate(fd, bytes) == -1)
+                {
+                    int err = errno;
+                    close(fd);
+                    throw std::system_error(err, std::system_category());
+                }
+
+                //先保留两倍的地址空间 再把同一个文件映射到前后两半
+                char *data = (char *)mmap(nullptr, bytes * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (data == MAP_FAILED ||
+                    mmap(data, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                    mmap(data + bytes, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+                {
+                    int err = errno;
+                    if (data != MAP_FAILED)
+                        munmap(data, bytes * 2);
+                    close(fd);
+                    throw std::system_error(err, std::system_category());
+                }
+
+                close(fd);
+                return reinterpret_cast<T_ *>(data);
+            }
+
+            void deallocate(T_ *p, size_type n)
+            {
+                munmap(p, n * sizeof(T_) * 2);
+            }
+        };
+
+        template <typename T, typename U>
+        bool operator==(const mirror_allocator<T> &, const mirror_allocator<U> &)
+        {
+            return true;
+        }
+
+        template <typename T, typename U>
+        bool operator!=(const mirror_allocator<T> &, const mirror_allocator<U> &)
+        {
+            return false;
+        }
+
+        //分配器是否提供镜像映射
+        template <typename Allocator, typename = void>
+        struct is_mirrored : std::false_type
+        {
+        };
+
+        template <typename Allocator>
+        struct is_mirrored<Allocator, std::void_t<decltype(Allocator::mirrored)>> : std::bool_constant<Allocator::mirrored>
+        {
+        };
+
+        template <typename Allocator>
+        inline constexpr bool is_mirrored_v = is_mirrored<Allocator>::value;
+    } // namespace parallelism
+} // namespace mio
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "mio/parallelism/utility.hpp"
+#include "mio/parallelism/wait.hpp"
+#include "mio/parallelism/detail/ring_index.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <stdexcept>
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //多生产者 单消费者 字节管道, 以记录为单位读写
+        //写者用一次 fetch_add 预留 [记录头 + 数据] 的空间, 写入数据后再写记录头发布
+        //读者按预留顺序读取, 记录头为 0 表示尚未发布, 读完后清零以便下一圈复用
+        //空间以 8 字节为单位, N_ 为字节数
+        template <typename Allocator = std::allocator<char>, size_t N_ = dynamic_extent, typename Event = wait::null_event>
+        class mpsc_pipe
+        {
+        private:
+            using word = std::atomic<uint64_t>;
+            using allocator_traits = typename std::allocator_traits<Allocator>::template rebind_traits<word>;
+
+            static constexpr size_t WORD_SIZE = sizeof(word);
+            static constexpr size_t WORDS = N_ == dynamic_extent ? dynamic_extent : N_ / WORD_SIZE;
+
+        public:
+            using allocator_type = typename allocator_traits::allocator_type;
+
+            using size_type = typename allocator_traits::size_type;
+
+        private:
+            alignas(CACHE_LINE) const detail::ring_index<WORDS> index_;
+
+            allocator_type allocator_;
+
+            typename allocator_traits::pointer data_;
+
+            //写者预留的界限
+            alignas(CACHE_LINE) std::atomic<size_type> writable_limit_;
+
+            //读者释放的界限
+            alignas(CACHE_LINE) std::atomic<size_type> readable_limit_;
+
+            //可读可写的事件, Event 为 wait::event 时可以阻塞等待
+            alignas(CACHE_LINE) Event readable_event_;
+            Event writable_event_;
+
+            static size_type get_words(size_type size)
+            {
+                return (size + WORD_SIZE - 1) / WORD_SIZE;
+            }
+
+            word &get_word(size_type index)
+            {
+                return this->data_[this->index_.get_index(index)];
+            }
+
+            char *get_bytes(size_type index)
+            {
+                return reinterpret_cast<char *>(std::addressof(this->get_word(index)));
+            }
+
+            //环形拷贝, 跨越末尾时分为两段
+            void copy_in(size_type index, const char *data, size_type size)
+            {
+                size_type len = (this->index_.max_size() - this->index_.get_index(index)) * WORD_SIZE;
+                if (size > len)
+                {
+                    memcpy(this->get_bytes(index), data, len);
+                    memcpy(this->get_bytes(0), data + len, size - len);
+                }
+                else
+                {
+                    memcpy(this->get_bytes(index), data, size);
+                }
+            }
+
+            void copy_out(size_type index, char *result, size_type size)
+            {
+                size_type len = (this->index_.max_size() - this->index_.get_index(index)) * WORD_SIZE;
+                if (size > len)
+                {
+                    memcpy(result, this->get_bytes(index), len);
+                    memcpy(result + len, this->get_bytes(0), size - len);
+                }
+                else
+                {
+                    memcpy(result, this->get_bytes(index), size);
+                }
+            }
+
+            void construct()
+            {
+                this->data_ = allocator_traits::allocate(allocator_, this->index_.max_size());
+                for (size_type i = 0; i < this->index_.max_size(); i++)
+                    new (std::addressof(this->data_[i])) word(0);
+            }
+
+        public:
+            mpsc_pipe()
+                : mpsc_pipe(N_)
+            {
+                static_assert(N_ != dynamic_extent, "a runtime sized mpsc_pipe needs max_size");
+            }
+
+            mpsc_pipe(size_type max_size)
+                : index_(get_words(max_size)), writable_limit_(0), readable_limit_(0)
+            {
+                this->construct();
+            }
+
+            mpsc_pipe(size_type max_size, const allocator_type &allocator)
+                : index_(get_words(max_size)), allocator_(allocator), writable_limit_(0), readable_limit_(0)
+            {
+                this->construct();
+            }
+
+            ~mpsc_pipe()
+            {
+                allocator_traits::deallocate(allocator_, this->data_, this->index_.max_size());
+            }
+
+            //写入一条 size 字节的记录, 多个写者可并发调用
+            //记录连同记录头不能超过容量
+            template <typename Handler = wait::yield_t>
+            void write(const void *data, size_type size, Handler &&handler = Handler())
+            {
+                size_type words = 1 + get_words(size);
+                if (words > this->index_.max_size())
+                    throw std::length_error("The record is larger than the mpsc_pipe");
+
+                size_type index = writable_limit_.fetch_add(words);
+
+                //等待读者释放足够的空间
+                for (size_t i = 0; index + words - readable_limit_.load(std::memory_order_acquire) > this->index_.max_size(); i++)
+                    handler(i);
+
+                this->copy_in(index + 1, static_cast<const char *>(data), size);
+
+                //发布记录
+                this->get_word(index).store(size + 1, std::memory_order_release);
+                readable_event_.notify();
+            }
+
+            //读取下一条已发布的记录, 返回记录的字节数, 只能由一个读者调用
+            //result 至少需要 max 字节, 记录超过 max 时抛出 length_error 且不消费该记录
+            template <typename Handler = wait::yield_t>
+            size_type read(void *result, size_type max, Handler &&handler = Handler())
+            {
+                size_type index = readable_limit_.load(std::memory_order_relaxed);
+                word &header = this->get_word(index);
+
+                uint64_t value;
+
+                //等待记录发布
+                for (size_t i = 0; !(value = header.load(std::memory_order_acquire)); i++)
+                    handler(i);
+
+                size_type size = value - 1;
+                if (size > max)
+                    throw std::length_error("The record is larger than the buffer");
+
+                this->copy_out(index + 1, static_cast<char *>(result), size);
+
+                //清零整条记录, 下一圈的记录头可能落在其中任意位置
+                size_type words = 1 + get_words(size);
+                for (size_type i = 0; i < words; i++)
+                    this->get_word(index + i).store(0, std::memory_order_relaxed);
+
+                readable_limit_.store(index + words, std::memory_order_release);
+                writable_event_.notify();
+                return size;
+            }
+
+            //没有已发布的记录时返回 false
+            bool try_read(void *result, size_type max, size_type &size)
+            {
+                if (!this->get_word(readable_limit_.load(std::memory_order_relaxed)).load(std::memory_order_acquire))
+                    return false;
+
+                size = this->read(result, max);
+                return true;
+            }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用
+            Event &readable_event()
+            {
+                return this->readable_event_;
+            }
+
+            Event &writable_event()
+            {
+                return this->writable_event_;
+            }
+
+            //已预留但尚未读取的字节数, 包含记录头
+            size_type size() const
+            {
+                size_type readable_limit = readable_limit_.load(std::memory_order_acquire);
+                size_type writable_limit = writable_limit_.load(std::memory_order_acquire);
+
+                return (writable_limit - readable_limit) * WORD_SIZE;
+            }
+
+            bool empty() const
+            {
+                return !this->size();
+            }
+
+            bool is_lock_free() const
+            {
+                return true;
+            }
+
+            size_type max_size() const
+            {
+                return this->index_.max_size() * WORD_SIZE;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -1,6 +1,9 @@
 #pragma once
 
 #include "mio/parallelism/utility.hpp"
+#include "mio/parallelism/wait.hpp"
+#include "mio/parallelism/mirror_allocator.hpp"
+#include "mio/parallelism/detail/ring_index.hpp"
 
 #include <stddef.h>
 
@@ -14,7 +17,7 @@ namespace mio
 {
     namespace parallelism
     {
-        template <typename T, typename Allocator = std::allocator<T>>
+        template <typename T, typename Allocator = std::allocator<T>, size_t N_ = dynamic_extent, typename Event = wait::null_event>
         class pipe
         {
         private:
@@ -35,68 +38,176 @@ namespace mio
 
             using const_pointer = typename allocator_traits::const_pointer;
 
+            //环形缓冲区中的一段连续内存
+            struct buffer
+            {
+                value_type *data;
+                size_type size;
+            };
+
+            //跨越缓冲区末尾时分为两段
+            using buffers = std::array<buffer, 2>;
+
         private:
-            alignas(CACHE_LINE) const size_type max_size_;
+            //镜像映射时 任意不超过容量的区间都是连续的, 读写无需拆分
+            static constexpr bool MIRRORED = is_mirrored_v<Allocator>;
+
+            //页大小在运行时才能确定, 固定容量无法保证是整页
+            static_assert(!MIRRORED || N_ == dynamic_extent, "a mirrored pipe must use dynamic_extent");
+
+            alignas(CACHE_LINE) const detail::ring_index<N_> index_;
 
             allocator_type allocator_;
 
             alignas(CACHE_LINE) pointer data_;
 
+            //写端: 可写界限 与 缓存的可读界限
             alignas(CACHE_LINE) std::atomic<size_type> writable_limit_;
+            size_type readable_cache_;
+
+            //读端: 可读界限 与 缓存的可写界限
             alignas(CACHE_LINE) std::atomic<size_type> readable_limit_;
+            size_type writable_cache_;
+
+            //可读可写的事件, Event 为 wait::event 时可以阻塞等待
+            alignas(CACHE_LINE) Event readable_event_;
+            Event writable_event_;
 
             size_type get_index(size_type index) const
             {
-                return index % this->max_size();
+                return this->index_.get_index(index);
             }
 
+            //镜像映射以页为单位
+            static size_type round_size(size_type max_size)
+            {
+                if constexpr (MIRRORED)
+                    return allocator_type::round_size(max_size);
+                else
+                    return max_size;
+            }
+
+            //写端可写的数量, 只在缓存显示不足 count 时才重新读取可读界限
+            size_type writable_size(size_type count)
+            {
+                size_type writable_limit = writable_limit_.load(std::memory_order_relaxed);
+                size_type size = this->max_size() - (writable_limit - readable_cache_);
+                if (size < count)
+                {
+                    readable_cache_ = readable_limit_.load(std::memory_order_acquire);
+                    size = this->max_size() - (writable_limit - readable_cache_);
+                }
+
+                return size;
+            }
+
+            //读端可读的数量, 只在缓存显示不足 count 时才重新读取可写界限
+            size_type readable_size(size_type count)
+            {
+                size_type readable_limit = readable_limit_.load(std::memory_order_relaxed);
+                size_type size = writable_cache_ - readable_limit;
+                if (size < count)
+                {
+                    writable_cache_ = writable_limit_.load(std::memory_order_acquire);
+                    size = writable_cache_ - readable_limit;
+                }
+
+                return size;
+            }
+
+            //复制到 limit 处, 不发布
             template <typename InputIt>
-            void __write(InputIt first, size_type count)
+            void copy_in(size_type limit, InputIt first, size_type count)
             {
-                auto max_size = this->max_size();
+                size_type index = get_index(limit);
 
-                if ((writable_limit_ % max_size) + count > max_size)
+                if (!MIRRORED && index + count > this->max_size())
                 {
-                    auto len = max_size - (writable_limit_ % max_size);
-                    std::copy_n(first, len, this->data_ + get_index(writable_limit_));
-                    std::copy_n(first + len, count - len, this->data_ + get_index(writable_limit_ + len));
+                    auto len = this->max_size() - index;
+                    std::copy_n(first, len, this->data_ + index);
+                    std::copy_n(first + len, count - len, this->data_);
                 }
                 else
                 {
-                    std::copy_n(first, count, this->data_ + get_index(writable_limit_));
+                    std::copy_n(first, count, this->data_ + index);
                 }
-                writable_limit_ += count;
             }
 
+            //从 limit 处复制出来, 不释放
             template <typename OutputIt>
-            void __read(OutputIt result, size_type count)
+            void copy_out(size_type limit, OutputIt result, size_type count)
             {
-                auto max_size = this->max_size();
+                size_type index = get_index(limit);
 
-                if ((readable_limit_ % max_size) + count > max_size)
+                if (!MIRRORED && index + count > this->max_size())
                 {
-                    auto len = max_size - (readable_limit_ % max_size);
-                    std::copy_n(std::move_iterator(this->data_ + get_index(readable_limit_)), len, result);
-                    std::copy_n(std::move_iterator(this->data_ + get_index(readable_limit_ + len)), count - len, result + len);
+                    auto len = this->max_size() - index;
+                    std::copy_n(std::move_iterator(this->data_ + index), len, result);
+                    std::copy_n(std::move_iterator(this->data_), count - len, result + len);
                 }
                 else
                 {
-                    std::copy_n(std::move_iterator(this->data_ + get_index(readable_limit_)), count, result);
+                    std::copy_n(std::move_iterator(this->data_ + index), count, result);
                 }
-                readable_limit_ += count;
+            }
+
+            template <typename InputIt>
+            void __write(InputIt first, size_type count)
+            {
+                size_type limit = writable_limit_.load(std::memory_order_relaxed);
+                this->copy_in(limit, first, count);
+
+                writable_limit_.store(limit + count, std::memory_order_release);
+                readable_event_.notify();
+            }
+
+            template <typename OutputIt>
+            void __read(OutputIt result, size_type count)
+            {
+                size_type limit = readable_limit_.load(std::memory_order_relaxed);
+                this->copy_out(limit, result, count);
+
+                readable_limit_.store(limit + count, std::memory_order_release);
+                writable_event_.notify();
+            }
+
+            //一组缓冲区的元素总数
+            template <typename BufferIt>
+            static size_type total_size(BufferIt first, BufferIt last)
+            {
+                size_type count = 0;
+                for (; first != last; ++first)
+                    count += first->size;
+
+                return count;
+            }
+
+            //从 index 开始的 count 个元素
+            buffers get_buffers(size_type index, size_type count)
+            {
+                size_type first = get_index(index);
+                size_type len = MIRRORED ? count : std::min(count, this->max_size() - first);
+
+                return {buffer{std::addressof(this->data_[first]), len}, buffer{std::addressof(this->data_[0]), count - len}};
             }
 
         public:
+            pipe()
+                : pipe(N_)
+            {
+                static_assert(N_ != dynamic_extent, "a runtime sized pipe needs max_size");
+            }
+
             pipe(size_type max_size)
-                : max_size_(max_size), writable_limit_(0), readable_limit_(0)
+                : index_(round_size(max_size)), writable_limit_(0), readable_cache_(0), readable_limit_(0), writable_cache_(0)
             {
-                this->data_ = allocator_traits::allocate(allocator_, max_size);
+                this->data_ = allocator_traits::allocate(allocator_, this->max_size());
             }
 
             pipe(size_type max_size, const allocator_type &allocator)
-                : max_size_(max_size), allocator_(allocator), writable_limit_(0), readable_limit_(0)
+                : index_(round_size(max_size)), allocator_(allocator), writable_limit_(0), readable_cache_(0), readable_limit_(0), writable_cache_(0)
             {
-                this->data_ = allocator_traits::allocate(allocator_, max_size);
+                this->data_ = allocator_traits::allocate(allocator_, this->max_size());
             }
 
             ~pipe()
@@ -104,14 +215,14 @@ namespace mio
                 allocator_traits::deallocate(allocator_, this->data_, this->max_size());
             }
 
-            template <typename InputIt>
-            size_type write_some(InputIt first, size_type count, const wait::handler_t &handler = wait::yield)
+            template <typename InputIt, typename Handler = wait::yield_t>
+            size_type write_some(InputIt first, size_type count, Handler &&handler = Handler())
             {
                 size_type size = 0;
 
                 for (size_type i = 0; !size; i++)
                 {
-                    size = this->max_size() - this->size();
+                    size = this->writable_size(1);
                     if (!size)
                         handler(i);
                 }
@@ -122,15 +233,15 @@ namespace mio
                 return size;
             }
 
-            template <typename OutputIt>
-            size_type read_some(OutputIt result, size_type count, const wait::handler_t &handler = wait::yield)
+            template <typename OutputIt, typename Handler = wait::yield_t>
+            size_type read_some(OutputIt result, size_type count, Handler &&handler = Handler())
             {
 
                 size_type size = 0;
 
                 for (size_type i = 0; !size; i++)
                 {
-                    size = this->size();
+                    size = this->readable_size(1);
                     if (!size)
                         handler(i);
                 }
@@ -141,11 +252,11 @@ namespace mio
                 return size;
             }
 
-            template <typename InputIt>
-            size_type write(InputIt first, size_type count, const wait::handler_t &handler = wait::yield)
+            template <typename InputIt, typename Handler = wait::yield_t>
+            size_type write(InputIt first, size_type count, Handler &&handler = Handler())
             {
                 //等待可写
-                for (size_type i = 0; this->max_size() - this->size() < count; i++)
+                for (size_type i = 0; this->writable_size(count) < count; i++)
                 {
                     handler(i);
                 }
@@ -154,11 +265,11 @@ namespace mio
                 return count;
             }
 
-            template <typename OutputIt>
-            size_type read(OutputIt result, size_type count, const wait::handler_t &handler = wait::yield)
+            template <typename OutputIt, typename Handler = wait::yield_t>
+            size_type read(OutputIt result, size_type count, Handler &&handler = Handler())
             {
                 //等待可读
-                for (size_type i = 0; this->size() < count; i++)
+                for (size_type i = 0; this->readable_size(count) < count; i++)
                 {
                     handler(i);
                 }
@@ -167,9 +278,137 @@ namespace mio
                 return count;
             }
 
+            //聚集写: 把 [first, last) 中每个缓冲区 {data, size} 的内容作为一条记录写入
+            //整条记录只发布一次, 读端要么看到全部 要么一个也看不到
+            //总长度超过容量时 退化为分段写入, 不再是一条完整的记录
+            template <typename BufferIt, typename Handler = wait::yield_t>
+            size_type write_v(BufferIt first, BufferIt last, Handler &&handler = Handler())
+            {
+                size_type count = total_size(first, last);
+                if (count > this->max_size())
+                {
+                    for (; first != last; ++first)
+                    {
+                        auto data = static_cast<const value_type *>(first->data);
+                        for (size_type n = 0; n < first->size;)
+                            n += this->write_some(data + n, first->size - n, handler);
+                    }
+
+                    return count;
+                }
+
+                //等待可写
+                for (size_type i = 0; this->writable_size(count) < count; i++)
+                {
+                    handler(i);
+                }
+
+                size_type limit = writable_limit_.load(std::memory_order_relaxed);
+                for (size_type offset = 0; first != last; ++first)
+                {
+                    this->copy_in(limit + offset, static_cast<const value_type *>(first->data), first->size);
+                    offset += first->size;
+                }
+
+                writable_limit_.store(limit + count, std::memory_order_release);
+                readable_event_.notify();
+                return count;
+            }
+
+            //分散读: 依次填满 [first, last) 中的每个缓冲区 {data, size}, 读端界限只推进一次
+            template <typename BufferIt, typename Handler = wait::yield_t>
+            size_type read_v(BufferIt first, BufferIt last, Handler &&handler = Handler())
+            {
+                size_type count = total_size(first, last);
+                if (count > this->max_size())
+                {
+                    for (; first != last; ++first)
+                    {
+                        auto data = static_cast<value_type *>(first->data);
+                        for (size_type n = 0; n < first->size;)
+                            n += this->read_some(data + n, first->size - n, handler);
+                    }
+
+                    return count;
+                }
+
+                //等待可读
+                for (size_type i = 0; this->readable_size(count) < count; i++)
+                {
+                    handler(i);
+                }
+
+                size_type limit = readable_limit_.load(std::memory_order_relaxed);
+                for (size_type offset = 0; first != last; ++first)
+                {
+                    this->copy_out(limit + offset, static_cast<value_type *>(first->data), first->size);
+                    offset += first->size;
+                }
+
+                readable_limit_.store(limit + count, std::memory_order_release);
+                writable_event_.notify();
+                return count;
+            }
+
+            //等待 count 个可写空间, 返回可直接写入的内存, 写入后调用 commit 发布
+            template <typename Handler = wait::yield_t>
+            buffers prepare(size_type count, Handler &&handler = Handler())
+            {
+                //等待可写
+                for (size_type i = 0; this->writable_size(count) < count; i++)
+                {
+                    handler(i);
+                }
+
+                return this->get_buffers(writable_limit_.load(std::memory_order_relaxed), count);
+            }
+
+            //发布 prepare 得到的前 count 个元素
+            void commit(size_type count)
+            {
+                writable_limit_.store(writable_limit_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+                readable_event_.notify();
+            }
+
+            //等待至少一个元素可读, 返回所有可读数据所在的内存, 读取后调用 consume 释放
+            template <typename Handler = wait::yield_t>
+            buffers peek(Handler &&handler = Handler())
+            {
+                size_type size = 0;
+
+                //等待可读
+                for (size_type i = 0; !(size = this->readable_size(1)); i++)
+                {
+                    handler(i);
+                }
+
+                return this->get_buffers(readable_limit_.load(std::memory_order_relaxed), size);
+            }
+
+            //释放 peek 得到的前 count 个元素
+            void consume(size_type count)
+            {
+                readable_limit_.store(readable_limit_.load(std::memory_order_relaxed) + count, std::memory_order_release);
+                writable_event_.notify();
+            }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用, 如 read(result, count, wait::blocking(readable_event()))
+            Event &readable_event()
+            {
+                return this->readable_event_;
+            }
+
+            Event &writable_event()
+            {
+                return this->writable_event_;
+            }
+
             size_type size() const
             {
-                return writable_limit_ - readable_limit_;
+                size_type readable_limit = readable_limit_.load(std::memory_order_acquire);
+                size_type writable_limit = writable_limit_.load(std::memory_order_acquire);
+
+                return writable_limit - readable_limit;
             }
 
             bool empty() const
@@ -184,7 +423,7 @@ namespace mio
 
             size_type max_size() const
             {
-                return max_size_;
+                return this->index_.max_size();
             }
         };
     } // namespace parallelism
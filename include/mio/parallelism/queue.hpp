@@ -1,58 +1,59 @@
 #pragma once
 
-#include "mio/parallelism/aba_ptr.hpp"
 #include "mio/parallelism/allocator.hpp"
+#include "mio/parallelism/hazard_domain.hpp"
+
+#include <atomic>
+#include <utility>
+#include <new>
 
 namespace mio
 {
     namespace parallelism
     {
-        template <typename T_>
+        //Allocator 为节点的定长分配器, 默认每个线程一个弹匣
+        template <typename T_, template <typename> class Allocator = allocator>
         class queue
         {
         private:
             struct node
             {
-                std::atomic<aba_ptr<node>> next;
+                std::atomic<node *> next;
                 T_ value;
             };
 
-            allocator<node> allocator_;
-            std::atomic<aba_ptr<node>> head_;
-            std::atomic<aba_ptr<node>> tail_;
+            Allocator<node> allocator_;
 
-        public:
-            queue()
-            {
-                //先构造一个头节点
-                head_ = allocator_.allocate();
-                head_.load()->next = nullptr;
-                tail_ = head_.load();
-            }
+            //出队的头节点经风险指针域退休, 没有线程访问后才回到分配器
+            hazard_domain<2> domain_;
 
-            ~queue()
+            alignas(CACHE_LINE) std::atomic<node *> head_;
+            alignas(CACHE_LINE) std::atomic<node *> tail_;
+
+            static void reclaim(void *ptr, void *context)
             {
-                while (head_.load())
-                {
-                    aba_ptr<node> next = head_.load()->next;
-                    allocator_.deallocate(head_);
-                    head_ = next;
-                }
+                node *n = static_cast<node *>(ptr);
+                n->~node();
+                static_cast<queue *>(context)->allocator_.deallocate(n);
             }
 
-            void push(const T_ &val)
+            template <typename U>
+            void __push(U &&val)
             {
-                auto n = allocator_.allocate();
-                n->value = val;
-                n->next = nullptr;
+                node *n = new (allocator_.allocate()) node{{nullptr}, std::forward<U>(val)};
+
+                typename hazard_domain<2>::guard guard(domain_);
 
                 while (1)
                 {
-                    aba_ptr<node> last = tail_.load();
-                    aba_ptr<node> exp = last->next;
+                    node *last = guard.protect(0, tail_);
+                    node *exp = last->next;
+
+                    if (last != tail_.load())
+                        continue;
 
                     //如果 last next 是 null 就代表是最后一个节点
-                    if(exp != nullptr)
+                    if (exp != nullptr)
                     {
                         tail_.compare_exchange_strong(last, exp);
                     }
@@ -61,71 +62,75 @@ namespace mio
                         //将tail 指向新节点
                         tail_.compare_exchange_strong(last, n);
                         return;
-                    }                    
+                    }
                 }
             }
 
-            void push(T_ &&val)
+        public:
+            queue()
             {
-                auto n = allocator_.allocate();
-                n->value = std::move(val);
+                //先构造一个头节点
+                node *n = new (allocator_.allocate()) node();
                 n->next = nullptr;
 
-                while (1)
-                {
-                    aba_ptr<node> last = tail_.load();
-                    aba_ptr<node> exp = last->next;
+                head_ = n;
+                tail_ = n;
+            }
 
-                    //如果 last next 是 null 就代表是最后一个节点
-                    if(exp != nullptr)
-                    {
-                        tail_.compare_exchange_strong(last, exp);
-                    }
-                    else if (last->next.compare_exchange_weak(exp, n))
-                    {
-                        //将tail 指向新节点
-                        tail_.compare_exchange_strong(last, n);
-                        return;
-                    }  
+            ~queue()
+            {
+                node *n = head_;
+                while (n)
+                {
+                    node *next = n->next;
+                    reclaim(n, this);
+                    n = next;
                 }
             }
 
+            void push(const T_ &val)
+            {
+                this->__push(val);
+            }
+
+            void push(T_ &&val)
+            {
+                this->__push(std::move(val));
+            }
+
             void pop(T_ &val)
             {
+                typename hazard_domain<2>::guard guard(domain_);
+
                 while (1)
                 {
-                    aba_ptr<node> first = head_;
-                    aba_ptr<node> last = tail_;
-                    aba_ptr<node> next = first->next;
+                    node *first = guard.protect(0, head_);
+                    node *last = tail_;
+                    node *next = guard.protect(1, first->next);
+
+                    //first 仍是头节点时 next 尚未出队, 受保护后不会被回收
+                    if (first != head_.load())
+                        continue;
+
+                    //队列为空
+                    if (next == nullptr)
+                        continue;
 
-                    //如果队列中有元素
                     if (first == last)
                     {
-                        if (next == nullptr)
-                        {
-                            continue;
-                        }
-
                         tail_.compare_exchange_strong(last, next);
                     }
-                    else
+                    else if (head_.compare_exchange_weak(first, next))
                     {
-                        if (next == nullptr)
-                        {
-                            continue;
-                        }
-
-                        //n队列为空
-                        val = next->value;
-                        if (head_.compare_exchange_weak(first, next))
-                        {
-                            //删除 first
-                            allocator_.deallocate(first);
-                            return;
-                        }
+                        //只有成功出队的线程访问 next 的值
+                        val = std::move(next->value);
+
+                        guard.reset(0);
+                        guard.retire(first, &queue::reclaim, this);
+                        return;
                     }
                 }
             }
         };
     } // namespace parallelism
-} // namespace mio
\ No newline at end of file
+} // namespace mio
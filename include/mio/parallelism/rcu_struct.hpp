@@ -0,0 +1,127 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+#include "mio/parallelism/epoch_domain.hpp"
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //读-复制-更新, 每个版本都是不可变的 T_
+        //读者取得当前版本的指针, 不加锁也不重试, 写者发布新版本, 旧版本交给回收域
+        //适合读取远多于写入的配置与符号表
+        template <typename T_, typename Domain = epoch_domain<>>
+        class rcu_struct
+        {
+        private:
+            std::atomic<T_ *> ptr_;
+
+            Domain *domain_;
+
+            static void reclaim(void *ptr, void *)
+            {
+                delete static_cast<T_ *>(ptr);
+            }
+
+            void retire(T_ *ptr, typename Domain::guard &guard)
+            {
+                guard.retire(ptr, &rcu_struct::reclaim, nullptr);
+            }
+
+        public:
+            //读取到的版本, 存活期间不会被释放
+            class snapshot
+            {
+            private:
+                typename Domain::guard guard_;
+                const T_ *ptr_;
+
+            public:
+                explicit snapshot(const rcu_struct &rcu)
+                    : guard_(*rcu.domain_), ptr_(guard_.protect(0, rcu.ptr_))
+                {
+                }
+
+                snapshot(const snapshot &) = delete;
+                snapshot &operator=(const snapshot &) = delete;
+
+                const T_ *get() const
+                {
+                    return ptr_;
+                }
+
+                const T_ &operator*() const
+                {
+                    return *ptr_;
+                }
+
+                const T_ *operator->() const
+                {
+                    return ptr_;
+                }
+            };
+
+            //默认使用进程内共享的域
+            explicit rcu_struct(const T_ &value = T_(), Domain &domain = Domain::instance())
+                : ptr_(new T_(value)), domain_(&domain)
+            {
+            }
+
+            rcu_struct(const rcu_struct &) = delete;
+            rcu_struct &operator=(const rcu_struct &) = delete;
+
+            //此时不应再有 snapshot 存活
+            ~rcu_struct()
+            {
+                delete ptr_.load();
+            }
+
+            snapshot read() const
+            {
+                return snapshot(*this);
+            }
+
+            operator T_() const
+            {
+                return *this->read();
+            }
+
+            //发布新版本
+            void store(const T_ &value)
+            {
+                typename Domain::guard guard(*domain_);
+                this->retire(ptr_.exchange(new T_(value)), guard);
+            }
+
+            rcu_struct &operator=(const T_ &value)
+            {
+                this->store(value);
+                return *this;
+            }
+
+            //在当前版本的副本上调用 function 后发布, 期间有其他写者发布时重试
+            template <typename Function>
+            void update(Function &&function)
+            {
+                typename Domain::guard guard(*domain_);
+
+                T_ *exp = guard.protect(0, ptr_);
+                while (1)
+                {
+                    T_ *ptr = new T_(*exp);
+                    function(*ptr);
+
+                    if (ptr_.compare_exchange_strong(exp, ptr))
+                        break;
+
+                    delete ptr;
+                    exp = guard.protect(0, ptr_);
+                }
+
+                this->retire(exp, guard);
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -2,6 +2,7 @@
 
 #include "mio/parallelism/detail/ring_buffer.hpp"
 #include "mio/parallelism/utility.hpp"
+#include "mio/parallelism/wait.hpp"
 
 #include <stddef.h>
 
@@ -14,7 +15,7 @@ namespace mio
 {
     namespace parallelism
     {
-        template <typename T, typename Allocator = std::allocator<T>>
+        template <typename T, typename Allocator = std::allocator<T>, size_t N_ = dynamic_extent, typename Layout = layout::padded, typename Event = wait::null_event>
         class ring_queue
         {
         private:
@@ -36,68 +37,235 @@ namespace mio
             using const_pointer = typename allocator_traits::const_pointer;
 
         private:
-            size_type max_size_;
-            detail::ring_buffer<value_type, Allocator> buffer_;
+            //序号与值放在同一个槽位中
+            //第 lap 圈: 序号为 lap * 2 时可写, lap * 2 + 1 时可读
+            struct slot
+            {
+                std::atomic<size_type> sequence;
+                value_type value;
+            };
 
-            //可读可写标志
-            detail::ring_buffer<std::atomic<size_type>, Allocator> readable_flag_;
-            detail::ring_buffer<std::atomic<size_type>, Allocator> writable_flag_;
+            detail::ring_buffer<slot, Allocator, N_, Layout> buffer_;
 
             //可读可写界限
             alignas(CACHE_LINE) std::atomic<size_type> readable_limit_;
             alignas(CACHE_LINE) std::atomic<size_type> writable_limit_;
 
-        public:
-            ring_queue(size_type max_size)
-            :max_size_(max_size), buffer_(max_size), readable_flag_(max_size), writable_flag_(max_size), readable_limit_(0), writable_limit_(0)
+            //可读可写的事件, Event 为 wait::event 时可以阻塞等待
+            alignas(CACHE_LINE) Event readable_event_;
+            Event writable_event_;
+
+            //圈数
+            size_type get_lap(size_type index) const
+            {
+                return this->buffer_.get_lap(index);
+            }
+
+            bool writable(size_type index) const
+            {
+                return buffer_[index].sequence == this->get_lap(index) * 2;
+            }
+
+            bool readable(size_type index) const
             {
-                for (size_t i = 0; i < max_size; i++)
+                return buffer_[index].sequence == this->get_lap(index) * 2 + 1;
+            }
+
+            template <typename U>
+            void write(size_type index, U &&val)
+            {
+                buffer_[index].value = std::forward<U>(val);
+                buffer_[index].sequence = this->get_lap(index) * 2 + 1;
+                readable_event_.notify();
+            }
+
+            template <typename U>
+            void read(size_type index, U &&val)
+            {
+                val = std::move(buffer_[index].value);
+                buffer_[index].sequence = this->get_lap(index) * 2 + 2;
+                writable_event_.notify();
+            }
+
+            //领取从 readable_limit_ 起已发布的连续槽位, 至多 max 个, 返回领取的个数
+            //只统计已发布的槽位, 因此不会领取尚未写入的序号
+            size_type claim_readable(size_type max, size_t &index)
+            {
+                index = this->readable_limit_;
+
+                while (1)
                 {
-                    readable_flag_[i] = 0;
-                    writable_flag_[i] = 0;
+                    size_type count = 0;
+                    while (count < max && this->readable(index + count))
+                        count++;
+
+                    if (!count || this->readable_limit_.compare_exchange_weak(index, index + count))
+                        return count;
                 }
             }
 
-            ring_queue(size_type max_size, const Allocator& alloc)
-            :max_size_(max_size), buffer_(max_size, alloc), readable_flag_(max_size, alloc), writable_flag_(max_size, alloc), readable_limit_(0), writable_limit_(0)
+        public:
+            ring_queue()
+            :ring_queue(N_)
+            {
+                static_assert(N_ != dynamic_extent, "a runtime sized ring_queue needs max_size");
+            }
+
+            ring_queue(size_type max_size)
+            :buffer_(max_size), readable_limit_(0), writable_limit_(0)
             {
+                for (size_t i = 0; i < this->max_size(); i++)
+                    buffer_[i].sequence = 0;
+            }
 
+            ring_queue(size_type max_size, const Allocator& alloc)
+            :buffer_(max_size, alloc), readable_limit_(0), writable_limit_(0)
+            {
+                for (size_t i = 0; i < this->max_size(); i++)
+                    buffer_[i].sequence = 0;
             }
 
-            void push(const T &val, const wait::handler_t &handler = wait::yield)
+            template <typename Handler = wait::yield_t>
+            void push(const T &val, Handler &&handler = Handler())
             {
                 size_t index = this->writable_limit_.fetch_add(1);
 
                 //等待可写
-                for (size_t i = 0; writable_flag_[index] != index / this->max_size(); i++)
+                for (size_t i = 0; !this->writable(index); i++)
                     handler(i);
 
-                this->buffer_[index] = val;
-                readable_flag_[index] = (index / this->max_size()) + 1;
+                this->write(index, val);
             }
 
-            void push(T &&val, const wait::handler_t &handler = wait::yield)
+            template <typename Handler = wait::yield_t>
+            void push(T &&val, Handler &&handler = Handler())
             {
                 size_t index = this->writable_limit_.fetch_add(1);
 
                 //等待可写
-                for (size_t i = 0; writable_flag_[index] != index / this->max_size(); i++)
+                for (size_t i = 0; !this->writable(index); i++)
                     handler(i);
 
-                this->buffer_[index] = std::move(val);
-                readable_flag_[index] = (index / this->max_size()) + 1;
+                this->write(index, std::move(val));
             }
 
-            void pop(T &val, const wait::handler_t &handler = wait::yield)
+            template <typename Handler = wait::yield_t>
+            void pop(T &val, Handler &&handler = Handler())
             {
                 size_t index = this->readable_limit_.fetch_add(1);
 
                 //等待可读
-                for (size_t i = 0; readable_flag_[index] != (index / this->max_size()) + 1; i++)
+                for (size_t i = 0; !this->readable(index); i++)
+                    handler(i);
+
+                this->read(index, val);
+            }
+
+            //仅当槽位可写时才领取, 否则立即返回 false
+            bool try_push(const T &val)
+            {
+                size_t index = this->writable_limit_;
+
+                do
+                {
+                    if (!this->writable(index))
+                        return false;
+                } while (!this->writable_limit_.compare_exchange_weak(index, index + 1));
+
+                this->write(index, val);
+                return true;
+            }
+
+            bool try_push(T &&val)
+            {
+                size_t index = this->writable_limit_;
+
+                do
+                {
+                    if (!this->writable(index))
+                        return false;
+                } while (!this->writable_limit_.compare_exchange_weak(index, index + 1));
+
+                this->write(index, std::move(val));
+                return true;
+            }
+
+            //仅当槽位可读时才领取, 否则立即返回 false
+            bool try_pop(T &val)
+            {
+                size_t index = this->readable_limit_;
+
+                do
+                {
+                    if (!this->readable(index))
+                        return false;
+                } while (!this->readable_limit_.compare_exchange_weak(index, index + 1));
+
+                this->read(index, val);
+                return true;
+            }
+
+            //一次 fetch_add 领取 count 个连续槽位 然后依次写入, 每个槽位被读空前逐个等待
+            //与 pop_n 不对称: 写端总能预先领取, 读端只能领取已发布的槽位
+            template <typename InputIt, typename Handler = wait::yield_t>
+            void push_n(InputIt first, size_type count, Handler &&handler = Handler())
+            {
+                size_t index = this->writable_limit_.fetch_add(count);
+
+                for (size_t n = 0; n < count; n++, ++first)
+                {
+                    //等待可写
+                    for (size_t i = 0; !this->writable(index + n); i++)
+                        handler(i);
+
+                    this->write(index + n, *first);
+                }
+            }
+
+            //一次 CAS 领取至多 max 个已发布的连续槽位 然后依次读出, 返回读出的个数
+            //不使用 fetch_add: 预先领取尚未发布的序号会让读者卡在慢的写者上, 也会让其他读者越过空洞
+            //没有可读数据时等待, 有数据时立即返回已发布的部分, 读出的个数可能小于 max
+            template <typename OutputIt, typename Handler = wait::yield_t>
+            size_type pop_n(OutputIt result, size_type max, Handler &&handler = Handler())
+            {
+                if (!max)
+                    return 0;
+
+                size_t index;
+                size_type count;
+
+                //等待可读
+                for (size_t i = 0; !(count = this->claim_readable(max, index)); i++)
                     handler(i);
 
-                val = std::move(this->buffer_[index]);
-                writable_flag_[index] = (index / this->max_size()) + 1;
+                for (size_t n = 0; n < count; n++, ++result)
+                    this->read(index + n, *result);
+
+                return count;
+            }
+
+            //没有可读数据时返回 0
+            template <typename OutputIt>
+            size_type try_pop_n(OutputIt result, size_type max)
+            {
+                size_t index;
+                size_type count = this->claim_readable(max, index);
+
+                for (size_t n = 0; n < count; n++, ++result)
+                    this->read(index + n, *result);
+
+                return count;
+            }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用, 如 pop(val, wait::blocking(readable_event()))
+            Event &readable_event()
+            {
+                return this->readable_event_;
+            }
+
+            Event &writable_event()
+            {
+                return this->writable_event_;
             }
 
             size_t size() const
@@ -110,7 +278,7 @@ namespace mio
 
             size_t max_size() const
             {
-                return this->max_size_;
+                return this->buffer_.max_size();
             }
 
             bool empty() const
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+#include <type_traits>
+
+#include "mio/parallelism/utility.hpp"
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //顺序锁, 单个写者 多个读者
+        //写者在写入前后各递增一次序号, 读者乐观地复制数据, 前后序号不一致或为奇数时重试
+        //读者不写任何共享内存, 不含指针与堆内存, 可以直接放在共享内存中跨进程使用
+        //数据以 8 字节原子字保存, 并发读写不构成数据竞争
+        template <typename T_>
+        class seqlock
+        {
+            static_assert(std::is_trivially_copyable_v<T_>, "seqlock requires a trivially copyable type");
+            static_assert(std::atomic<uint64_t>::is_always_lock_free, "seqlock requires lock free 64 bit atomics");
+
+        private:
+            using word = std::atomic<uint64_t>;
+
+            static constexpr size_t WORD_SIZE = sizeof(word);
+            static constexpr size_t WORDS = (sizeof(T_) + WORD_SIZE - 1) / WORD_SIZE;
+
+            alignas(CACHE_LINE) std::atomic<uint64_t> sequence_ = 0;
+
+            word data_[WORDS] = {};
+
+            void copy_in(const T_ &value)
+            {
+                uint64_t buffer[WORDS] = {};
+                memcpy(buffer, &value, sizeof(T_));
+
+                for (size_t i = 0; i < WORDS; i++)
+                    data_[i].store(buffer[i], std::memory_order_relaxed);
+            }
+
+            void copy_out(T_ &value) const
+            {
+                uint64_t buffer[WORDS];
+                for (size_t i = 0; i < WORDS; i++)
+                    buffer[i] = data_[i].load(std::memory_order_relaxed);
+
+                memcpy(&value, buffer, sizeof(T_));
+            }
+
+        public:
+            seqlock() = default;
+
+            seqlock(const T_ &value)
+            {
+                this->copy_in(value);
+            }
+
+            seqlock(const seqlock &) = delete;
+            seqlock &operator=(const seqlock &) = delete;
+
+            //只能由一个写者调用
+            void store(const T_ &value)
+            {
+                uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+                sequence_.store(sequence + 1, std::memory_order_relaxed);
+
+                //奇数序号先于数据可见
+                std::atomic_thread_fence(std::memory_order_release);
+
+                this->copy_in(value);
+
+                sequence_.store(sequence + 2, std::memory_order_release);
+            }
+
+            seqlock &operator=(const T_ &value)
+            {
+                this->store(value);
+                return *this;
+            }
+
+            //读取一致的副本, 与写者冲突时重试
+            template <typename Handler = wait::active_t>
+            T_ load(Handler &&handler = Handler()) const
+            {
+                T_ value;
+                for (size_t i = 0; !this->try_load(value); i++)
+                    handler(i);
+
+                return value;
+            }
+
+            operator T_() const
+            {
+                return this->load();
+            }
+
+            //与写者冲突时返回 false
+            bool try_load(T_ &value) const
+            {
+                uint64_t sequence = sequence_.load(std::memory_order_acquire);
+                if (sequence & 1)
+                    return false;
+
+                this->copy_out(value);
+
+                //数据的读取先于再次读取序号
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                return sequence_.load(std::memory_order_relaxed) == sequence;
+            }
+
+            //已完成的写入次数
+            uint64_t version() const
+            {
+                return sequence_.load(std::memory_order_acquire) / 2;
+            }
+
+            bool is_lock_free() const
+            {
+                return true;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -0,0 +1,235 @@
+#pragma once
+
+#include "mio/parallelism/utility.hpp"
+#include "mio/parallelism/wait.hpp"
+
+#include <stddef.h>
+
+#include <atomic>
+#include <utility>
+#include <memory>
+#include <new>
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //单生产者 单消费者 环形队列
+        //不使用每个槽位的标志, 只依赖读写界限, 并各自缓存对端的界限
+        template <typename T, typename Allocator = std::allocator<T>, typename Event = wait::null_event>
+        class spsc_ring_queue
+        {
+        private:
+            using allocator_traits = std::allocator_traits<Allocator>;
+
+        public:
+            using value_type = typename allocator_traits::value_type;
+
+            using allocator_type = typename allocator_traits::allocator_type;
+
+            using size_type = typename allocator_traits::size_type;
+
+            using reference = typename allocator_traits::value_type &;
+
+            using const_reference = const typename allocator_traits::value_type &;
+
+            using pointer = typename allocator_traits::pointer;
+
+            using const_pointer = typename allocator_traits::const_pointer;
+
+        private:
+            alignas(CACHE_LINE) const size_type max_size_;
+            const size_type mask_;
+
+            allocator_type allocator_;
+
+            pointer data_;
+
+            //写端: 可写界限 与 缓存的可读界限
+            alignas(CACHE_LINE) std::atomic<size_type> writable_limit_;
+            size_type readable_cache_;
+
+            //读端: 可读界限 与 缓存的可写界限
+            alignas(CACHE_LINE) std::atomic<size_type> readable_limit_;
+            size_type writable_cache_;
+
+            //可读可写的事件, Event 为 wait::event 时可以阻塞等待
+            alignas(CACHE_LINE) Event readable_event_;
+            Event writable_event_;
+
+            //向上取整到 2 的幂
+            static size_type ceil_pow2(size_type size)
+            {
+                size_type ret = 1;
+                while (ret < size)
+                    ret <<= 1;
+
+                return ret;
+            }
+
+            void construct()
+            {
+                this->data_ = allocator_traits::allocate(allocator_, this->max_size());
+                for (size_type i = 0; i < this->max_size(); i++)
+                    new (&this->data_[i]) value_type();
+            }
+
+            //是否可写, 只在缓存显示已满时才重新读取可读界限
+            bool writable(size_type index)
+            {
+                if (index - readable_cache_ == this->max_size())
+                {
+                    readable_cache_ = readable_limit_.load(std::memory_order_acquire);
+                    return index - readable_cache_ != this->max_size();
+                }
+
+                return true;
+            }
+
+            //是否可读, 只在缓存显示为空时才重新读取可写界限
+            bool readable(size_type index)
+            {
+                if (index == writable_cache_)
+                {
+                    writable_cache_ = writable_limit_.load(std::memory_order_acquire);
+                    return index != writable_cache_;
+                }
+
+                return true;
+            }
+
+        public:
+            spsc_ring_queue(size_type max_size)
+                : max_size_(ceil_pow2(max_size)), mask_(ceil_pow2(max_size) - 1), writable_limit_(0), readable_cache_(0), readable_limit_(0), writable_cache_(0)
+            {
+                this->construct();
+            }
+
+            spsc_ring_queue(size_type max_size, const allocator_type &allocator)
+                : max_size_(ceil_pow2(max_size)), mask_(ceil_pow2(max_size) - 1), allocator_(allocator), writable_limit_(0), readable_cache_(0), readable_limit_(0), writable_cache_(0)
+            {
+                this->construct();
+            }
+
+            ~spsc_ring_queue()
+            {
+                for (size_type i = 0; i < this->max_size(); i++)
+                    this->data_[i].~value_type();
+
+                allocator_traits::deallocate(allocator_, this->data_, this->max_size());
+            }
+
+            bool try_push(const T &val)
+            {
+                size_type index = writable_limit_.load(std::memory_order_relaxed);
+                if (!this->writable(index))
+                    return false;
+
+                this->data_[index & mask_] = val;
+                writable_limit_.store(index + 1, std::memory_order_release);
+                readable_event_.notify();
+                return true;
+            }
+
+            bool try_push(T &&val)
+            {
+                size_type index = writable_limit_.load(std::memory_order_relaxed);
+                if (!this->writable(index))
+                    return false;
+
+                this->data_[index & mask_] = std::move(val);
+                writable_limit_.store(index + 1, std::memory_order_release);
+                readable_event_.notify();
+                return true;
+            }
+
+            bool try_pop(T &val)
+            {
+                size_type index = readable_limit_.load(std::memory_order_relaxed);
+                if (!this->readable(index))
+                    return false;
+
+                val = std::move(this->data_[index & mask_]);
+                readable_limit_.store(index + 1, std::memory_order_release);
+                writable_event_.notify();
+                return true;
+            }
+
+            template <typename Handler = wait::yield_t>
+            void push(const T &val, Handler &&handler = Handler())
+            {
+                size_type index = writable_limit_.load(std::memory_order_relaxed);
+
+                //等待可写
+                for (size_t i = 0; !this->writable(index); i++)
+                    handler(i);
+
+                this->data_[index & mask_] = val;
+                writable_limit_.store(index + 1, std::memory_order_release);
+                readable_event_.notify();
+            }
+
+            template <typename Handler = wait::yield_t>
+            void push(T &&val, Handler &&handler = Handler())
+            {
+                size_type index = writable_limit_.load(std::memory_order_relaxed);
+
+                //等待可写
+                for (size_t i = 0; !this->writable(index); i++)
+                    handler(i);
+
+                this->data_[index & mask_] = std::move(val);
+                writable_limit_.store(index + 1, std::memory_order_release);
+                readable_event_.notify();
+            }
+
+            template <typename Handler = wait::yield_t>
+            void pop(T &val, Handler &&handler = Handler())
+            {
+                size_type index = readable_limit_.load(std::memory_order_relaxed);
+
+                //等待可读
+                for (size_t i = 0; !this->readable(index); i++)
+                    handler(i);
+
+                val = std::move(this->data_[index & mask_]);
+                readable_limit_.store(index + 1, std::memory_order_release);
+                writable_event_.notify();
+            }
+
+            //Event 为 wait::event 时配合 wait::blocking 使用
+            Event &readable_event()
+            {
+                return this->readable_event_;
+            }
+
+            Event &writable_event()
+            {
+                return this->writable_event_;
+            }
+
+            size_type size() const
+            {
+                size_type readable_limit = readable_limit_.load(std::memory_order_acquire);
+                size_type writable_limit = writable_limit_.load(std::memory_order_acquire);
+
+                return writable_limit - readable_limit;
+            }
+
+            size_type max_size() const
+            {
+                return this->max_size_;
+            }
+
+            bool empty() const
+            {
+                return !this->size();
+            }
+
+            bool is_lock_free() const
+            {
+                return true;
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
@@ -1,74 +1,199 @@
 #pragma once
 
-#include "mio/parallelism/aba_ptr.hpp"
 #include "mio/parallelism/allocator.hpp"
+#include "mio/parallelism/hazard_domain.hpp"
+#include "mio/parallelism/wait.hpp"
+
+#include <atomic>
+#include <array>
+#include <utility>
+#include <new>
 
 namespace mio
 {
     namespace parallelism
     {
-        template <typename T_>
+        //ELIMINATION_NUM_ 为消除数组的槽位数, 为 0 时不使用消除
+        //Allocator 为节点的定长分配器, 默认每个线程一个弹匣
+        template <typename T_, size_t ELIMINATION_NUM_ = 16, template <typename> class Allocator = allocator>
         class stack
         {
         private:
             struct node
             {
-                std::atomic<aba_ptr<node>> next;
+                std::atomic<node *> next;
                 T_ value;
             };
 
-            allocator<node> allocator_;
-            std::atomic<aba_ptr<node>> top_;
+            Allocator<node> allocator_;
+
+            //被弹出的节点经风险指针域退休, 没有线程访问后才回到分配器
+            hazard_domain<1> domain_;
+
+            alignas(CACHE_LINE) std::atomic<node *> top_;
+
+            //消除数组: push 在 top_ 竞争失败时把节点挂到槽位上等待, pop 竞争失败时直接取走
+            //成对的 push 与 pop 互相抵消, 不再访问 top_
+            struct alignas(CACHE_LINE) exchanger
+            {
+                std::atomic<node *> offer = nullptr;
+            };
+
+            //push 在槽位上等待的次数
+            static constexpr size_t SPIN_COUNT = 128;
+
+            std::array<exchanger, ELIMINATION_NUM_> exchangers_;
+
+            //当前使用的槽位数, 在 1 与 ELIMINATION_NUM_ 之间自适应
+            alignas(CACHE_LINE) std::atomic<size_t> width_ = 1;
+
+            exchanger &get_exchanger(size_t attempt)
+            {
+                size_t width = width_.load(std::memory_order_relaxed);
+                return exchangers_[(thread_index() + attempt) % width];
+            }
+
+            //槽位冲突说明竞争激烈 扩大范围, 等不到对方说明范围过大 缩小范围
+            void widen()
+            {
+                size_t width = width_.load(std::memory_order_relaxed);
+                if (width < ELIMINATION_NUM_)
+                    width_.compare_exchange_weak(width, width * 2, std::memory_order_relaxed);
+            }
+
+            void narrow()
+            {
+                size_t width = width_.load(std::memory_order_relaxed);
+                if (width > 1)
+                    width_.compare_exchange_weak(width, width / 2, std::memory_order_relaxed);
+            }
+
+            //把 n 交给一个并发的 pop, 成功返回 true
+            bool eliminate_push(node *n, size_t attempt)
+            {
+                exchanger &e = this->get_exchanger(attempt);
+
+                node *exp = nullptr;
+                if (!e.offer.compare_exchange_strong(exp, n, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    this->widen();
+                    return false;
+                }
+
+                for (size_t i = 0; i < SPIN_COUNT && e.offer.load(std::memory_order_relaxed) == n; i++)
+                    wait::cpu_relax();
+
+                //撤回失败说明已被 pop 取走
+                exp = n;
+                if (!e.offer.compare_exchange_strong(exp, nullptr, std::memory_order_relaxed))
+                    return true;
+
+                this->narrow();
+                return false;
+            }
+
+            //从槽位上取走一个等待的 push, 成功返回 true
+            bool eliminate_pop(T_ &val, size_t attempt)
+            {
+                exchanger &e = this->get_exchanger(attempt);
+
+                node *n = e.offer.load(std::memory_order_relaxed);
+                if (!n || !e.offer.compare_exchange_strong(n, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+                    return false;
+
+                //取走的节点只属于当前线程, 不需要经过风险指针域
+                val = std::move(n->value);
+                reclaim(n, this);
+                return true;
+            }
+
+            static void reclaim(void *ptr, void *context)
+            {
+                node *n = static_cast<node *>(ptr);
+                n->~node();
+                static_cast<stack *>(context)->allocator_.deallocate(n);
+            }
+
+            template <typename U>
+            void __push(U &&val)
+            {
+                node *n = new (allocator_.allocate()) node{{nullptr}, std::forward<U>(val)};
+
+                node *exp = top_.load(std::memory_order_relaxed);
+
+                for (size_t attempt = 0;; attempt++)
+                {
+                    n->next.store(exp, std::memory_order_relaxed);
+                    if (top_.compare_exchange_weak(exp, n, std::memory_order_release, std::memory_order_relaxed))
+                        return;
+
+                    //只有竞争失败时才尝试消除, 无竞争时没有额外开销
+                    if constexpr (ELIMINATION_NUM_ != 0)
+                    {
+                        if (this->eliminate_push(n, attempt))
+                            return;
+
+                        exp = top_.load(std::memory_order_relaxed);
+                    }
+                }
+            }
 
         public:
             stack()
             {
                 top_ = nullptr;
             }
+
             ~stack()
             {
-                while (top_.load())
+                node *n = top_;
+                while (n)
                 {
-                    aba_ptr<node> next = top_.load()->next;
-                    allocator_.deallocate(top_);
-                    top_ = next;
+                    node *next = n->next;
+                    reclaim(n, this);
+                    n = next;
                 }
             }
 
             void push(const T_ &val)
             {
-                aba_ptr<node> n = allocator_.allocate();
-                n->value = val;
-
-                aba_ptr<node> exp = top_;
-                n->next = exp;
+                this->__push(val);
+            }
 
-                while (!top_.compare_exchange_weak(exp, n))
-                {
-                    n->next = exp;
-                }
+            void push(T_ &&val)
+            {
+                this->__push(std::move(val));
             }
 
             void pop(T_ &val)
             {
-                aba_ptr<node> exp = top_;
-                aba_ptr<node> ret = exp;
+                typename hazard_domain<1>::guard guard(domain_);
 
-                while (!exp || !top_.compare_exchange_weak(exp, exp->next))
+                for (size_t attempt = 0;; attempt++)
                 {
-                    while (!exp)
+                    //受保护的节点不会被回收, 读取 next 与 CAS 都不会遇到 ABA
+                    node *exp = guard.protect(0, top_);
+                    if (exp)
                     {
-                        exp = top_;
+                        node *next = exp->next.load(std::memory_order_relaxed);
+                        if (top_.compare_exchange_weak(exp, next, std::memory_order_acquire, std::memory_order_relaxed))
+                        {
+                            val = std::move(exp->value);
+                            guard.reset(0);
+                            guard.retire(exp, &stack::reclaim, this);
+                            return;
+                        }
                     }
 
-                    ret = exp;
+                    //栈为空或竞争失败时 尝试与等待中的 push 抵消
+                    if constexpr (ELIMINATION_NUM_ != 0)
+                    {
+                        if (this->eliminate_pop(val, attempt))
+                            return;
+                    }
                 }
-
-                val = std::move(ret->value);
-
-                allocator_.deallocate(exp);
             }
         };
 
     } // namespace parallelism
-} // namespace mio
\ No newline at end of file
+} // namespace mio
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace mio
+{
+    namespace parallelism
+    {
+        //指针与 64 位计数, 通过 128 位 CAS 整体比较交换
+        //与 aba_ptr 不同, 不占用指针高位, 计数实际上不会回绕
+        //只在 x86-64 上提供原子操作, 其他平台使用 aba_ptr
+        template <typename T_>
+        class tagged_ptr
+        {
+        private:
+            friend class std::atomic<tagged_ptr<T_>>;
+
+            T_ *ptr_;
+            uint64_t tag_;
+
+        public:
+            tagged_ptr() = default;
+
+            tagged_ptr(T_ *ptr, uint64_t tag = 0)
+                : ptr_(ptr), tag_(tag)
+            {
+            }
+
+            T_ *get() const
+            {
+                return ptr_;
+            }
+
+            uint64_t tag() const
+            {
+                return tag_;
+            }
+
+            T_ &operator*() const
+            {
+                return *get();
+            }
+
+            T_ *operator->() const
+            {
+                return get();
+            }
+
+            operator T_ *() const
+            {
+                return get();
+            }
+        };
+    } // namespace parallelism
+} // namespace mio
+
+#if defined(__x86_64__)
+namespace std
+{
+    template <typename T_>
+    class atomic<mio::parallelism::tagged_ptr<T_>>
+    {
+    public:
+        using tagged_ptr = mio::parallelism::tagged_ptr<T_>;
+
+    private:
+        struct alignas(16) value_t
+        {
+            uint64_t ptr;
+            uint64_t tag;
+        };
+
+        value_t value_;
+
+        //失败时 expected 更新为当前值
+        static bool cas(value_t *dst, value_t &expected, value_t desired)
+        {
+            bool ret;
+            __asm__ __volatile__("lock cmpxchg16b %1"
+                                 : "=@ccz"(ret), "+m"(*dst), "+a"(expected.ptr), "+d"(expected.tag)
+                                 : "b"(desired.ptr), "c"(desired.tag)
+                                 : "memory");
+            return ret;
+        }
+
+        //两个字分别读取, 不独占缓存行, 结果可能不一致, 由随后的 CAS 校验
+        value_t load_relaxed() const
+        {
+            value_t ret;
+            ret.tag = __atomic_load_n(&value_.tag, __ATOMIC_ACQUIRE);
+            ret.ptr = __atomic_load_n(&value_.ptr, __ATOMIC_ACQUIRE);
+            return ret;
+        }
+
+        static value_t to_value(tagged_ptr ptr)
+        {
+            return value_t{(uint64_t)ptr.ptr_, ptr.tag_};
+        }
+
+        static tagged_ptr to_ptr(value_t value)
+        {
+            return tagged_ptr((T_ *)value.ptr, value.tag);
+        }
+
+    public:
+        atomic() = default;
+
+        atomic(const tagged_ptr &ptr)
+            : value_(to_value(ptr))
+        {
+        }
+
+        atomic &operator=(tagged_ptr desired)
+        {
+            store(desired);
+            return *this;
+        }
+
+        operator tagged_ptr()
+        {
+            return load();
+        }
+
+        void store(tagged_ptr desired)
+        {
+            value_t exp = load_relaxed();
+            while (!cas(&value_, exp, to_value(desired)))
+                ;
+        }
+
+        //可能读到不一致的指针与计数, 只能用作 CAS 的期望值
+        tagged_ptr load() const
+        {
+            return to_ptr(load_relaxed());
+        }
+
+        //成功时计数在 expected 的基础上加一, 失败时 expected 更新为当前值
+        bool compare_exchange_weak(tagged_ptr &expected, tagged_ptr desired)
+        {
+            value_t exp = to_value(expected);
+            value_t des{(uint64_t)desired.ptr_, expected.tag_ + 1};
+
+            bool ret = cas(&value_, exp, des);
+            expected = to_ptr(exp);
+            return ret;
+        }
+
+        bool compare_exchange_strong(tagged_ptr &expected, tagged_ptr desired)
+        {
+            return compare_exchange_weak(expected, desired);
+        }
+
+        bool is_lock_free() const
+        {
+            return true;
+        }
+    };
+} // namespace std
+#endif
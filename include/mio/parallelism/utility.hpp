@@ -2,6 +2,7 @@
 
 #include <stdint.h>
 
+#include <atomic>
 #include <thread>
 #include <functional>
 
@@ -11,12 +12,53 @@ namespace mio
     {
         namespace wait
         {
+            //类型擦除的等待策略, 需要保存策略时使用
             typedef std::function<void(size_t)> handler_t;
 
-            inline auto active = [](size_t) {};
-            inline auto yield = [](size_t) { std::this_thread::yield(); };
+            //等待策略以模板参数传入容器, 无竞争时可完全内联
+            struct active_t
+            {
+                void operator()(size_t) const {}
+            };
+
+            struct yield_t
+            {
+                void operator()(size_t) const { std::this_thread::yield(); }
+            };
+
+            inline constexpr active_t active{};
+            inline constexpr yield_t yield{};
         } // namespace wait
 
         inline constexpr size_t CACHE_LINE = 64;
+
+        //容量在运行时指定
+        inline constexpr size_t dynamic_extent = static_cast<size_t>(-1);
+
+        //线程编号, 按首次调用的顺序从 0 开始分配
+        inline size_t thread_index()
+        {
+            static std::atomic<size_t> count = 0;
+            thread_local size_t index = count++;
+
+            return index;
+        }
+
+        namespace layout
+        {
+            //每个槽位独占一条缓存行
+            struct padded
+            {
+                template <typename T>
+                static constexpr size_t line_slots = 1;
+            };
+
+            //槽位紧凑排列, 通过下标跨步让相邻下标落在不同缓存行
+            struct compact
+            {
+                template <typename T>
+                static constexpr size_t line_slots = sizeof(T) < CACHE_LINE ? CACHE_LINE / sizeof(T) : 1;
+            };
+        } // namespace layout
     } // namespace parallelism
 } // namespace mio
\ No newline at end of file
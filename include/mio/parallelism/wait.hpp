@@ -0,0 +1,187 @@
+#pragma once
+
+#include "mio/parallelism/utility.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+
+#include <atomic>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mio
+{
+    namespace parallelism
+    {
+        namespace wait
+        {
+            //自旋时让出流水线
+            inline void cpu_relax()
+            {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+                asm volatile("yield");
+#endif
+            }
+
+            struct pause_t
+            {
+                void operator()(size_t) const { cpu_relax(); }
+            };
+
+            //先 pause 自旋 再 yield
+            struct backoff_t
+            {
+                void operator()(size_t i) const
+                {
+                    if (i < 64)
+                        cpu_relax();
+                    else
+                        std::this_thread::yield();
+                }
+            };
+
+            inline constexpr pause_t pause{};
+            inline constexpr backoff_t backoff{};
+
+            //容器的默认事件, notify 为空操作, 不能配合 blocking 使用
+            //不需要阻塞等待时 读写路径上没有额外的屏障
+            struct null_event
+            {
+                void notify() {}
+            };
+
+            //可以阻塞等待的事件, 只有存在等待者时 notify 才会唤醒
+            //notify 需要一次全屏障与 prepare 配对, 只在需要阻塞的容器上使用
+            //不使用 FUTEX_PRIVATE_FLAG, 放在共享内存中可跨进程使用
+            class event
+            {
+            private:
+                std::atomic<uint32_t> sequence_;
+                std::atomic<uint32_t> waiters_;
+
+            public:
+                event()
+                    : sequence_(0), waiters_(0)
+                {
+                }
+
+                event(const event &) = delete;
+                event &operator=(const event &) = delete;
+
+                //登记为等待者 并返回当前序号, 调用者需在此之后再次检查条件
+                uint32_t prepare()
+                {
+                    waiters_.fetch_add(1);
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    return sequence_.load();
+                }
+
+                //取消登记
+                void cancel()
+                {
+                    waiters_.fetch_sub(1);
+                }
+
+                uint32_t sequence() const
+                {
+                    return sequence_.load();
+                }
+
+                //序号仍为 sequence 时阻塞, 可能虚假唤醒
+                void wait(uint32_t sequence)
+                {
+#ifdef __linux__
+                    syscall(SYS_futex, &sequence_, FUTEX_WAIT, sequence, nullptr, nullptr, 0);
+#else
+                    if (sequence_.load() == sequence)
+                        std::this_thread::yield();
+#endif
+                }
+
+                //条件发布之后调用
+                void notify()
+                {
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (!waiters_.load(std::memory_order_relaxed))
+                        return;
+
+                    sequence_.fetch_add(1);
+#ifdef __linux__
+                    syscall(SYS_futex, &sequence_, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+                }
+            };
+
+            //先 pause 自旋, 再 yield, 最后阻塞在 event 上
+            class blocking
+            {
+            public:
+                static constexpr size_t SPIN_COUNT = 64;
+                static constexpr size_t YIELD_COUNT = 64;
+
+            private:
+                event *event_;
+                bool registered_ = false;
+                uint32_t sequence_ = 0;
+
+            public:
+                blocking(event &event)
+                    : event_(&event)
+                {
+                }
+
+                //登记状态不随拷贝传递
+                blocking(const blocking &other)
+                    : event_(other.event_)
+                {
+                }
+
+                blocking &operator=(const blocking &) = delete;
+
+                ~blocking()
+                {
+                    if (registered_)
+                        event_->cancel();
+                }
+
+                void operator()(size_t i)
+                {
+                    //新的一轮等待 撤销上一轮遗留的登记
+                    if (i == 0 && registered_)
+                    {
+                        event_->cancel();
+                        registered_ = false;
+                    }
+
+                    if (i < SPIN_COUNT)
+                    {
+                        cpu_relax();
+                    }
+                    else if (i < SPIN_COUNT + YIELD_COUNT)
+                    {
+                        std::this_thread::yield();
+                    }
+                    else if (!registered_)
+                    {
+                        //先登记 返回后由调用者再次检查条件, 下一次调用才真正阻塞
+                        sequence_ = event_->prepare();
+                        registered_ = true;
+                    }
+                    else
+                    {
+                        event_->wait(sequence_);
+                        sequence_ = event_->sequence();
+                    }
+                }
+            };
+        } // namespace wait
+    }     // namespace parallelism
+} // namespace mio
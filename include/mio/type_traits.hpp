@@ -111,7 +111,7 @@ namespace mio
         template <typename T_>
         struct remove_container_type<T_, false>
         {
-            using type = remove_pointer_t<T_>;
+            using type = std::remove_pointer_t<T_>;
         };
     } // namespace detail
 
@@ -0,0 +1,106 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+constexpr size_t SIZE = 1000000;
+
+constexpr size_t WRITE_INTERVAL = 1000;
+
+#include "mio/parallelism/atomic_struct.hpp"
+#include "mio/parallelism/rcu_struct.hpp"
+#include "mio/parallelism/seqlock.hpp"
+
+using namespace mio::parallelism;
+
+struct quote
+{
+    size_t bid;
+    size_t ask;
+    size_t volume[6];
+};
+
+//读取一次并复制出来
+inline quote load(const atomic_struct<quote> &data)
+{
+    return data;
+}
+
+inline quote load(const rcu_struct<quote> &data)
+{
+    return *data.read();
+}
+
+inline quote load(const seqlock<quote> &data)
+{
+    return data;
+}
+
+class verify
+{
+public:
+    //thread_num 个读者反复读取, 一个写者每隔 WRITE_INTERVAL 纳秒写入一次, 返回每次读取的平均耗时
+    template <typename Struct>
+    size_t run_one(size_t thread_num)
+    {
+        auto data_ptr = std::make_unique<Struct>(quote{});
+        Struct &data = *data_ptr;
+
+        std::atomic<bool> stop = false;
+        std::atomic<size_t> read_diff = 0;
+
+        std::thread write_thread([&]() {
+            for (size_t i = 1; !stop; i++)
+            {
+                data = quote{i, i, {}};
+                std::this_thread::sleep_for(std::chrono::nanoseconds(WRITE_INTERVAL));
+            }
+        });
+
+        std::vector<std::thread> read_thread;
+        for (size_t i = 0; i < thread_num; i++)
+        {
+            read_thread.emplace_back([&]() {
+                auto start = std::chrono::steady_clock::now();
+                for (size_t n = 0; n < SIZE; n++)
+                {
+                    quote q = load(data);
+                    assert(q.bid == q.ask);
+                }
+                auto end = std::chrono::steady_clock::now();
+                read_diff += std::chrono::nanoseconds(end - start).count();
+            });
+        }
+
+        for (auto &thread : read_thread)
+        {
+            thread.join();
+        }
+
+        stop = true;
+        write_thread.join();
+
+        return read_diff / (SIZE * thread_num);
+    }
+
+    void run()
+    {
+        for (size_t thread_num = 1; thread_num <= 16; thread_num *= 2)
+        {
+            size_t mutex = run_one<atomic_struct<quote>>(thread_num);
+            size_t rcu = run_one<rcu_struct<quote>>(thread_num);
+            size_t seq = run_one<seqlock<quote>>(thread_num);
+            printf("threads/%lu\t atomic_struct/%lu ns\t rcu_struct/%lu ns\t seqlock/%lu ns\n", thread_num, mutex, rcu, seq);
+        }
+    }
+};
+
+int main(void)
+{
+    verify v;
+    v.run();
+    return 0;
+}
@@ -6,6 +6,8 @@
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
+#include <algorithm>
 
 constexpr size_t SIZE = 100000;
 
@@ -102,11 +104,172 @@ public:
     {
         (run_one<DATA_SIZE_>(), ...);
     }
+
+    template <size_t BATCH_SIZE_, size_t DATA_SIZE_ = 64>
+    void run_batch_one()
+    {
+        typedef mio::parallelism::disruptor<std::array<char, DATA_SIZE_>, BUF_SIZE> disruptor_t;
+        typedef typename disruptor_t::reader reader_t;
+
+        auto disruptor_ptr = std::make_unique<disruptor_t>();
+        disruptor_t &disruptor = *disruptor_ptr;
+        std::atomic<size_t> array[SIZE] = {0};
+
+        std::chrono::nanoseconds write_diff;
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread[THREAD_WRITE_NUM];
+        std::thread read_thread[THREAD_READ_NUM];
+
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            std::shared_ptr<reader_t> reader(disruptor_ptr->make_reader());
+            read_thread[i] = std::thread([&, reader]() {
+                std::vector<std::array<char, DATA_SIZE_>> data(BATCH_SIZE_);
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < THREAD_WRITE_NUM * SIZE;)
+                {
+                    size_t count = reader->pull_batch(data.begin(), std::min(BATCH_SIZE_, THREAD_WRITE_NUM * SIZE - i));
+                    for (size_t n = 0; n < count; n++)
+                    {
+                        size_t index = *(size_t *)&data[n][DATA_SIZE_ - sizeof(size_t)];
+                        array[index]++;
+                    }
+                    i += count;
+                }
+                auto end = std::chrono::steady_clock::now();
+                read_diff = end - start;
+            });
+        }
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i] = std::thread([&]() {
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < SIZE; i += BATCH_SIZE_)
+                {
+                    auto range = disruptor.claim(std::min(BATCH_SIZE_, SIZE - i));
+                    for (size_t n = 0; n < range.count; n++)
+                        *(size_t *)&disruptor[range.first + n][DATA_SIZE_ - sizeof(size_t)] = i + n;
+
+                    disruptor.publish(range);
+                }
+                auto end = std::chrono::steady_clock::now();
+                write_diff = end - start;
+            });
+        }
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i].join();
+        }
+
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            read_thread[i].join();
+        }
+
+        size_t max = 0;
+        size_t min = 0;
+        for (size_t i = 0; i < SIZE; i++)
+        {
+            if (array[i] != THREAD_WRITE_NUM * THREAD_READ_NUM)
+            {
+                if (array[i] > THREAD_WRITE_NUM * THREAD_READ_NUM)
+                    max++;
+                else
+                    min++;
+            }
+        }
+
+        assert(max == 0);
+        assert(min == 0);
+
+        printf("batch/%lu\t size/%lu byte\t w/%lu ns\t r/%lu ns\n", BATCH_SIZE_, DATA_SIZE_, write_diff.count() / (SIZE * THREAD_WRITE_NUM), read_diff.count() / (SIZE * THREAD_READ_NUM));
+    }
+
+    //两级读者, 下游读者只读取上游已处理过的数据
+    //上游原地标记每一项后再推进, 下游看到的每一项都必须已被标记, 且序号不超过上游已推进的数量
+    void run_pipeline()
+    {
+        struct item
+        {
+            size_t index;
+            size_t stage;
+        };
+
+        typedef mio::parallelism::disruptor<item, BUF_SIZE> disruptor_t;
+        typedef typename disruptor_t::reader reader_t;
+
+        auto disruptor_ptr = std::make_unique<disruptor_t>();
+        disruptor_t &disruptor = *disruptor_ptr;
+
+        std::atomic<size_t> upstream_done = 0;
+
+        std::unique_ptr<reader_t> upstream(disruptor.make_reader());
+        std::unique_ptr<reader_t> downstream(disruptor.make_reader({upstream.get()}));
+
+        std::chrono::nanoseconds read_diff;
+
+        std::thread upstream_thread([&]() {
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                item &val = upstream->peek();
+                assert(val.index == i);
+                val.stage = 1;
+
+                upstream_done.store(i + 1, std::memory_order_relaxed);
+                upstream->commit();
+            }
+        });
+
+        std::thread downstream_thread([&]() {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                item val;
+                downstream->pull(val);
+                assert(val.index == i);
+                assert(val.stage == 1);
+                assert(upstream_done.load(std::memory_order_relaxed) > i);
+            }
+            auto end = std::chrono::steady_clock::now();
+            read_diff = end - start;
+        });
+
+        std::thread write_thread([&]() {
+            for (size_t i = 0; i < SIZE; i++)
+                disruptor.push(item{i, 0});
+        });
+
+        write_thread.join();
+        upstream_thread.join();
+        downstream_thread.join();
+
+        //下游先销毁, 上游的 gate 随后才可以复用
+        downstream.reset();
+        upstream.reset();
+
+        std::unique_ptr<reader_t> readers[2];
+        for (auto &reader : readers)
+            reader.reset(disruptor.make_reader());
+
+        printf("pipeline/2 stage\t r/%lu ns\n", read_diff.count() / SIZE);
+    }
+
+    template <size_t... BATCH_SIZE_>
+    void run_batch()
+    {
+        (run_batch_one<BATCH_SIZE_>(), ...);
+    }
 };
 
 int main(void)
 {
     verify v;
     v.run<64, 128, 256, 512, 1024>();
+    v.run_batch<1, 8, 64, 512>();
+    v.run_pipeline();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,122 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+constexpr size_t SIZE = 1000000;
+
+constexpr size_t KEY_NUM = 4096;
+
+//每 WRITE_INTERVAL 次操作中 一次插入一次删除, 其余为查找
+constexpr size_t WRITE_INTERVAL = 20;
+
+#include "mio/parallelism/hash_map.hpp"
+#include "mio/parallelism/unordered_map.hpp"
+
+using namespace mio::parallelism;
+
+//现有用法, 以读写锁保护 phmap
+class locked_map
+{
+private:
+    unordered_map<size_t, size_t> map_;
+    std::shared_mutex mutex_;
+
+public:
+    bool find(size_t key, size_t &value)
+    {
+        std::shared_lock lock(mutex_);
+        auto it = map_.find(key);
+        if (it == map_.end())
+            return false;
+
+        value = it->second;
+        return true;
+    }
+
+    bool insert_or_assign(size_t key, size_t value)
+    {
+        std::lock_guard lock(mutex_);
+        return map_.insert_or_assign(key, value).second;
+    }
+
+    bool erase(size_t key)
+    {
+        std::lock_guard lock(mutex_);
+        return map_.erase(key);
+    }
+};
+
+class verify
+{
+public:
+    //thread_num 个线程各执行 SIZE 次操作, 返回每次操作的平均耗时
+    template <typename Map>
+    size_t run_one(size_t thread_num)
+    {
+        auto map_ptr = std::make_unique<Map>();
+        Map &map = *map_ptr;
+
+        for (size_t i = 0; i < KEY_NUM; i += 2)
+            map.insert_or_assign(i, i);
+
+        std::atomic<size_t> diff = 0;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < thread_num; i++)
+        {
+            threads.emplace_back([&, i]() {
+                size_t value;
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t n = 0; n < SIZE; n++)
+                {
+                    size_t key = (n * 2654435761 + i) % KEY_NUM;
+                    switch (n % WRITE_INTERVAL)
+                    {
+                    case 0:
+                        map.insert_or_assign(key, key);
+                        break;
+                    case 1:
+                        map.erase(key);
+                        break;
+                    default:
+                        if (map.find(key, value))
+                            assert(value == key);
+                    }
+                }
+                auto end = std::chrono::steady_clock::now();
+                diff += std::chrono::nanoseconds(end - start).count();
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        return diff / (SIZE * thread_num);
+    }
+
+    void run()
+    {
+        for (size_t thread_num = 1; thread_num <= 16; thread_num *= 2)
+        {
+            size_t lock_free = run_one<hash_map<size_t, size_t>>(thread_num);
+            size_t locked = run_one<locked_map>(thread_num);
+            printf("threads/%lu\t hash_map/%lu ns\t unordered_map/%lu ns\n", thread_num, lock_free, locked);
+        }
+    }
+};
+
+int main(void)
+{
+    verify v;
+    v.run();
+    return 0;
+}
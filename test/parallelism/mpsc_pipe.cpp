@@ -0,0 +1,99 @@
+#include "mio/parallelism/mpsc_pipe.hpp"
+
+#include <assert.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+
+constexpr size_t SIZE = 10000;
+
+constexpr size_t BUF_SIZE = 65536;
+
+constexpr size_t THREAD_WRITE_NUM = 4;
+
+class verify
+{
+public:
+    //每条记录为 [写者编号, 序号, 填充], 长度为 DATA_SIZE_
+    template <size_t DATA_SIZE_>
+    void run_one()
+    {
+        static_assert(DATA_SIZE_ >= sizeof(size_t) * 2);
+
+        mio::parallelism::mpsc_pipe<> pipe(BUF_SIZE);
+        size_t next[THREAD_WRITE_NUM] = {0};
+
+        std::chrono::nanoseconds write_diff[THREAD_WRITE_NUM];
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread[THREAD_WRITE_NUM];
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i] = std::thread([&, i]() {
+                char data[DATA_SIZE_];
+                ((size_t *)data)[0] = i;
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t n = 0; n < SIZE; n++)
+                {
+                    ((size_t *)data)[1] = n;
+                    pipe.write(data, DATA_SIZE_);
+                }
+                auto end = std::chrono::steady_clock::now();
+                write_diff[i] = end - start;
+            });
+        }
+
+        std::thread read_thread([&]() {
+            char data[DATA_SIZE_];
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t n = 0; n < SIZE * THREAD_WRITE_NUM; n++)
+            {
+                size_t size = pipe.read(data, DATA_SIZE_);
+                assert(size == DATA_SIZE_);
+
+                //同一写者的记录保持顺序
+                size_t id = ((size_t *)data)[0];
+                assert(((size_t *)data)[1] == next[id]);
+                next[id]++;
+            }
+            auto end = std::chrono::steady_clock::now();
+            read_diff = end - start;
+        });
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i].join();
+        }
+
+        read_thread.join();
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            assert(next[i] == SIZE);
+        }
+
+        size_t write_ns = 0;
+        for (auto &diff : write_diff)
+            write_ns += diff.count();
+
+        printf("size/%lu byte\t w/%lu ns\t r/%lu ns\n", DATA_SIZE_, write_ns / (SIZE * THREAD_WRITE_NUM), read_diff.count() / (SIZE * THREAD_WRITE_NUM));
+    }
+
+    template <size_t... DATA_SIZE_>
+    void run()
+    {
+        (run_one<DATA_SIZE_>(), ...);
+    }
+};
+
+int main(void)
+{
+    verify v;
+    v.run<16, 20, 64, 100, 1024>();
+    return 0;
+}
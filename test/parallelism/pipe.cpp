@@ -1,10 +1,14 @@
 #include "mio/parallelism/pipe.hpp"
+#include "mio/parallelism/channel.hpp"
+#include "mio/interprocess/pipe.hpp"
 
 #include <assert.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <iostream>
 #include <thread>
+#include <algorithm>
 
 constexpr size_t SIZE = 10000;
 
@@ -19,10 +23,10 @@ constexpr size_t THREAD_READ_NUM = 1;
 class verify
 {
 public:
-    template <size_t DATA_SIZE_>
+    template <template <typename> class Allocator_, size_t DATA_SIZE_>
     void run_one()
     {
-        mio::parallelism::pipe<std::array<char, DATA_SIZE_>> pipe(BUF_SIZE);
+        mio::parallelism::pipe<std::array<char, DATA_SIZE_>, Allocator_<std::array<char, DATA_SIZE_>>> pipe(BUF_SIZE);
         size_t array[SIZE] = {0};
 
         std::chrono::nanoseconds write_diff;
@@ -93,16 +97,458 @@ public:
         printf("size/%lu byte\t w/%lu ns\t r/%lu ns\n", DATA_SIZE_, write_diff.count() / SIZE, read_diff.count() / SIZE);
     }
 
-    template <size_t... DATA_SIZE_>
+    //字节流, 每次传输 CHUNK_ 字节
+    template <size_t CHUNK_>
+    void run_stream_one()
+    {
+        mio::parallelism::pipe<char> pipe(BUF_SIZE * 16);
+
+        std::chrono::nanoseconds write_diff;
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread([&]() {
+            std::vector<char> data(CHUNK_);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                data[0] = (char)i;
+                pipe.write(data.data(), CHUNK_);
+            }
+            auto end = std::chrono::steady_clock::now();
+            write_diff = end - start;
+        });
+
+        std::thread read_thread([&]() {
+            std::vector<char> data(CHUNK_);
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                pipe.read(data.data(), CHUNK_);
+                assert(data[0] == (char)i);
+            }
+            auto end = std::chrono::steady_clock::now();
+            read_diff = end - start;
+        });
+
+        write_thread.join();
+        read_thread.join();
+
+        printf("stream/%lu byte\t w/%lu ns\t r/%lu ns\n", CHUNK_, write_diff.count() / SIZE, read_diff.count() / SIZE);
+    }
+
+    //prepare/commit/peek/consume 跨越缓冲区末尾, 两段内存与部分提交 部分释放
+    void run_zero_copy_wrap()
+    {
+        mio::parallelism::pipe<char> pipe(16);
+        char data[16];
+
+        //把界限推进到 10
+        pipe.write(data, 10);
+        pipe.read(data, 10);
+
+        //[10, 16) 与 [0, 6)
+        auto out = pipe.prepare(12);
+        assert(out[0].size == 6);
+        assert(out[1].size == 6);
+        assert(out[1].data + 10 == out[0].data);
+
+        for (size_t i = 0; i < 12; i++)
+        {
+            if (i < out[0].size)
+                out[0].data[i] = (char)i;
+            else
+                out[1].data[i - out[0].size] = (char)i;
+        }
+
+        //只发布前 8 个, 其余 4 个对读端不可见
+        pipe.commit(8);
+        assert(pipe.size() == 8);
+
+        auto in = pipe.peek();
+        assert(in[0].size == 6);
+        assert(in[1].size == 2);
+        assert(in[0].data == out[0].data);
+        for (size_t i = 0; i < 8; i++)
+            assert((i < 6 ? in[0].data[i] : in[1].data[i - 6]) == (char)i);
+
+        //释放 5 个后 剩余的 [15, 16) 与 [0, 2)
+        pipe.consume(5);
+        assert(pipe.size() == 3);
+
+        in = pipe.peek();
+        assert(in[0].size == 1);
+        assert(in[1].size == 2);
+        assert(in[0].data[0] == 5 && in[1].data[0] == 6 && in[1].data[1] == 7);
+
+        pipe.consume(3);
+        assert(pipe.empty());
+
+        //未发布的部分不占用空间, 下一次 prepare 从 18 即下标 2 开始
+        out = pipe.prepare(16);
+        assert(out[0].data == in[1].data + 2);
+        assert(out[0].size == 14);
+        assert(out[1].size == 2);
+    }
+
+    //字节流, 写端与读端都直接访问缓冲区, 每次只提交 释放一部分
+    void run_zero_copy()
+    {
+        mio::parallelism::pipe<char> pipe(BUF_SIZE);
+        constexpr size_t TOTAL = SIZE * 64;
+
+        std::chrono::nanoseconds write_diff;
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread([&]() {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t n = 0, i = 0; n < TOTAL; i++)
+            {
+                size_t count = std::min<size_t>(1 + i % 97, TOTAL - n);
+                auto out = pipe.prepare(count);
+                assert(out[0].size + out[1].size == count);
+
+                //只提交大约一半, 剩余部分下一轮重新 prepare
+                size_t commit = (count + 1) / 2;
+                for (size_t j = 0; j < commit; j++)
+                {
+                    char c = (char)(n + j);
+                    if (j < out[0].size)
+                        out[0].data[j] = c;
+                    else
+                        out[1].data[j - out[0].size] = c;
+                }
+
+                pipe.commit(commit);
+                n += commit;
+            }
+            auto end = std::chrono::steady_clock::now();
+            write_diff = end - start;
+        });
+
+        std::thread read_thread([&]() {
+            auto start = std::chrono::steady_clock::now();
+            for (size_t n = 0, i = 0; n < TOTAL; i++)
+            {
+                auto in = pipe.peek();
+                size_t size = in[0].size + in[1].size;
+
+                size_t consume = std::min<size_t>(1 + i % 61, size);
+                for (size_t j = 0; j < consume; j++)
+                {
+                    char c = j < in[0].size ? in[0].data[j] : in[1].data[j - in[0].size];
+                    assert(c == (char)(n + j));
+                }
+
+                pipe.consume(consume);
+                n += consume;
+            }
+            auto end = std::chrono::steady_clock::now();
+            read_diff = end - start;
+        });
+
+        write_thread.join();
+        read_thread.join();
+
+        printf("zero copy\t w/%lu ns\t r/%lu ns\n", write_diff.count() / SIZE, read_diff.count() / SIZE);
+    }
+
+    //聚集写 分散读使用的缓冲区
+    struct io_buffer
+    {
+        void *data;
+        size_t size;
+    };
+
+    //定长记录由三段聚集写入, 读端观察到的数据量总是整条记录的倍数
+    //容量不是记录长度的倍数, 记录会跨越缓冲区末尾
+    template <typename Pipe_>
+    void run_write_v_one(Pipe_ &pipe, const char *name)
+    {
+        constexpr size_t RECORD = 24;
+        assert(pipe.max_size() % RECORD);
+
+        std::chrono::nanoseconds write_diff;
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread([&]() {
+            char head[8], body[12], tail[4];
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SIZE; i++)
+            {
+                memset(head, (char)i, sizeof(head));
+                memset(body, (char)i, sizeof(body));
+                memset(tail, (char)i, sizeof(tail));
+
+                io_buffer buffers[] = {{head, sizeof(head)}, {body, sizeof(body)}, {tail, sizeof(tail)}};
+                pipe.write_v(std::begin(buffers), std::end(buffers));
+            }
+            auto end = std::chrono::steady_clock::now();
+            write_diff = end - start;
+        });
+
+        std::thread read_thread([&]() {
+            char first[5], second[RECORD - 5];
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < SIZE;)
+            {
+                size_t size = pipe.size();
+                assert(size % RECORD == 0);
+                if (!size)
+                {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                //与写入不同的分段方式读出
+                io_buffer buffers[] = {{first, sizeof(first)}, {second, sizeof(second)}};
+                pipe.read_v(std::begin(buffers), std::end(buffers));
+
+                for (char c : first)
+                    assert(c == (char)i);
+                for (char c : second)
+                    assert(c == (char)i);
+                i++;
+            }
+            auto end = std::chrono::steady_clock::now();
+            read_diff = end - start;
+        });
+
+        write_thread.join();
+        read_thread.join();
+
+        printf("%s/%lu byte\t w/%lu ns\t r/%lu ns\n", name, RECORD, write_diff.count() / SIZE, read_diff.count() / SIZE);
+    }
+
+    //总长度超过容量时分段写入, 数据仍按顺序完整到达
+    template <typename Write_, typename Read_>
+    void run_write_v_oversize(size_t max_size, Write_ &&write_v, Read_ &&read_v)
+    {
+        std::vector<char> head(max_size / 2), body(max_size * 3);
+        for (size_t i = 0; i < head.size(); i++)
+            head[i] = (char)i;
+        for (size_t i = 0; i < body.size(); i++)
+            body[i] = (char)(head.size() + i);
+
+        std::thread write_thread([&]() {
+            io_buffer buffers[] = {{head.data(), head.size()}, {body.data(), body.size()}};
+            size_t size = write_v(std::begin(buffers), std::end(buffers));
+            assert(size == head.size() + body.size());
+        });
+
+        std::vector<char> result(head.size() + body.size());
+        io_buffer buffers[] = {{result.data(), max_size + 1}, {result.data() + max_size + 1, result.size() - max_size - 1}};
+        size_t size = read_v(std::begin(buffers), std::end(buffers));
+        assert(size == result.size());
+
+        write_thread.join();
+
+        for (size_t i = 0; i < result.size(); i++)
+            assert(result[i] == (char)i);
+    }
+
+    void run_write_v()
+    {
+        {
+            mio::parallelism::pipe<char> pipe(64);
+            this->run_write_v_one(pipe, "write_v");
+
+            this->run_write_v_oversize(
+                pipe.max_size(),
+                [&](io_buffer *first, io_buffer *last) { return pipe.write_v(first, last); },
+                [&](io_buffer *first, io_buffer *last) { return pipe.read_v(first, last); });
+        }
+
+        //channel 的两端各用一个方向
+        {
+            mio::parallelism::channel<char> channel(64);
+
+            this->run_write_v_oversize(
+                channel.max_size(true),
+                [&](io_buffer *first, io_buffer *last) { return channel.write_v(true, first, last); },
+                [&](io_buffer *first, io_buffer *last) { return channel.read_v(false, first, last); });
+
+            this->run_write_v_oversize(
+                channel.max_size(false),
+                [&](io_buffer *first, io_buffer *last) { return channel.write_v(false, first, last); },
+                [&](io_buffer *first, io_buffer *last) { return channel.read_v(true, first, last); });
+        }
+
+        //共享内存中的 socket, 阻塞读写
+        {
+            boost::asio::io_context io_context;
+            mio::interprocess::pipe::acceptor acceptor(io_context);
+            acceptor.bind("mio_test_pipe");
+
+            mio::interprocess::pipe::socket client(io_context);
+            client.connect("mio_test_pipe", 64, 64);
+
+            mio::interprocess::pipe::socket server(io_context);
+            acceptor.accept(server);
+
+            this->run_write_v_oversize(
+                64,
+                [&](io_buffer *first, io_buffer *last) { return client.write_v(first, last); },
+                [&](io_buffer *first, io_buffer *last) { return server.read_v(first, last); });
+
+            this->run_write_v_oversize(
+                64,
+                [&](io_buffer *first, io_buffer *last) { return server.write_v(first, last); },
+                [&](io_buffer *first, io_buffer *last) { return client.read_v(first, last); });
+        }
+    }
+
+    //半关闭, 读完剩余数据后才结束, 关闭时唤醒阻塞的读写
+    void run_shutdown()
+    {
+        using channel_t = mio::parallelism::channel<char, std::allocator<char>, mio::parallelism::dynamic_extent, mio::parallelism::wait::event>;
+        using mio::parallelism::wait::blocking;
+
+        char data[16] = {0};
+
+        //true 一端关闭写入, 另一方向不受影响
+        {
+            channel_t channel(16);
+            channel.write(true, data, 10);
+            channel.shutdown(true, channel_t::SHUT_WRITE);
+
+            bool thrown = false;
+            try
+            {
+                channel.write(true, data, 1);
+            }
+            catch (const std::runtime_error &)
+            {
+                thrown = true;
+            }
+            assert(thrown);
+
+            channel.write(false, data, 3);
+            assert(channel.read(true, data, 3) == 3);
+
+            //剩余的 10 个先读完, 之后 read_some 返回 0, read 抛出 end_of_stream
+            assert(channel.read(false, data, 4) == 4);
+
+            thrown = false;
+            try
+            {
+                channel.read(false, data, 8);
+            }
+            catch (const channel_t::end_of_stream &)
+            {
+                thrown = true;
+            }
+            assert(thrown);
+
+            assert(channel.read_some(false, data, 16) == 6);
+            assert(channel.read_some(false, data, 16) == 0);
+        }
+
+        //阻塞的读者在对端关闭写入时被唤醒
+        {
+            channel_t channel(16);
+            std::atomic<bool> thrown = false;
+
+            std::thread read_thread([&]() {
+                try
+                {
+                    channel.read(false, data, 1, blocking(channel.readable_event(false)));
+                }
+                catch (const channel_t::end_of_stream &)
+                {
+                    thrown = true;
+                }
+            });
+
+            //等读者阻塞在 event 上
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            channel.shutdown(true, channel_t::SHUT_WRITE);
+
+            read_thread.join();
+            assert(thrown);
+        }
+
+        //阻塞的写者在对端关闭读取时被唤醒
+        {
+            channel_t channel(16);
+            std::atomic<bool> thrown = false;
+
+            channel.write(true, data, channel.max_size(true));
+
+            std::thread write_thread([&]() {
+                try
+                {
+                    channel.write(true, data, 1, blocking(channel.writable_event(true)));
+                }
+                catch (const std::runtime_error &)
+                {
+                    thrown = true;
+                }
+            });
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            channel.shutdown(false, channel_t::SHUT_READ);
+
+            write_thread.join();
+            assert(thrown);
+        }
+
+        //socket 关闭写入后 对端读完剩余数据得到 0, 两端析构时先关闭 再由后关闭的一端释放通道
+        {
+            boost::asio::io_context io_context;
+            mio::interprocess::pipe::acceptor acceptor(io_context);
+            acceptor.bind("mio_test_pipe");
+
+            mio::interprocess::pipe::socket client(io_context);
+            client.connect("mio_test_pipe", 64, 64);
+
+            mio::interprocess::pipe::socket server(io_context);
+            acceptor.accept(server);
+
+            client.write(data, 5);
+            client.shutdown(channel_t::SHUT_WRITE);
+
+            assert(server.read_some(data, 16) == 5);
+            assert(server.read_some(data, 16) == 0);
+
+            server.write(data, 5);
+            assert(client.read(data, 5) == 5);
+        }
+
+        printf("shutdown\t ok\n");
+    }
+
+    template <size_t... CHUNK_>
+    void run_stream()
+    {
+        (run_stream_one<CHUNK_>(), ...);
+    }
+
+    template <template <typename> class Allocator_, size_t... DATA_SIZE_>
     void run()
     {
-        (run_one<DATA_SIZE_>(), ...);
+        (run_one<Allocator_, DATA_SIZE_>(), ...);
     }
 };
 
 int main(void)
 {
     verify v;
-    v.run<64, 128, 256, 512, 1024>();
+    v.run<std::allocator, 64, 128, 256, 512, 1024>();
+
+    printf("mirrored\n");
+    v.run<mio::parallelism::mirror_allocator, 64, 128, 256, 512, 1024>();
+
+    v.run_stream<1, 64, 4096>();
+
+    v.run_zero_copy_wrap();
+    v.run_zero_copy();
+
+    v.run_write_v();
+
+    v.run_shutdown();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <assert.h>
+#include <stdint.h>
+
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+constexpr size_t SIZE = 1000000;
+
+constexpr size_t WRITE_INTERVAL = 1000;
+
+#include "mio/parallelism/hazard_ptr.hpp"
+#include "mio/parallelism/epoch_domain.hpp"
+
+using namespace mio::parallelism;
+
+struct route
+{
+    size_t key;
+    size_t value;
+};
+
+class verify
+{
+public:
+    //thread_num 个读者反复读取, 一个写者每隔 WRITE_INTERVAL 纳秒替换一次, 返回每次读取的平均耗时
+    template <typename Domain>
+    size_t run_one(size_t thread_num)
+    {
+        Domain domain;
+        hazard_ptr<route, Domain> ptr(new route{0, 0}, domain);
+
+        std::atomic<bool> stop = false;
+        std::atomic<size_t> read_diff = 0;
+
+        std::thread write_thread([&]() {
+            for (size_t i = 1; !stop; i++)
+            {
+                ptr = new route{i, i};
+                std::this_thread::sleep_for(std::chrono::nanoseconds(WRITE_INTERVAL));
+            }
+        });
+
+        std::vector<std::thread> read_thread;
+        for (size_t i = 0; i < thread_num; i++)
+        {
+            read_thread.emplace_back([&]() {
+                auto start = std::chrono::steady_clock::now();
+                for (size_t n = 0; n < SIZE; n++)
+                {
+                    ref_ptr<route, Domain> ref(ptr);
+                    assert(ref->key == ref->value);
+                }
+                auto end = std::chrono::steady_clock::now();
+                read_diff += std::chrono::nanoseconds(end - start).count();
+            });
+        }
+
+        for (auto &thread : read_thread)
+        {
+            thread.join();
+        }
+
+        stop = true;
+        write_thread.join();
+
+        return read_diff / (SIZE * thread_num);
+    }
+
+    void run()
+    {
+        for (size_t thread_num = 1; thread_num <= 16; thread_num *= 2)
+        {
+            size_t hazard = run_one<hazard_domain<1>>(thread_num);
+            size_t epoch = run_one<epoch_domain<>>(thread_num);
+            printf("threads/%lu\t hazard/%lu ns\t epoch/%lu ns\n", thread_num, hazard, epoch);
+        }
+    }
+};
+
+int main(void)
+{
+    verify v;
+    v.run();
+    return 0;
+}
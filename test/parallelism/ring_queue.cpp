@@ -6,6 +6,8 @@
 #include <iostream>
 #include <memory>
 #include <thread>
+#include <vector>
+#include <algorithm>
 
 constexpr size_t SIZE = 10000;
 
@@ -18,10 +20,10 @@ constexpr size_t THREAD_READ_NUM = 8;
 class verify
 {
 public:
-    template <size_t DATA_SIZE_>
-    void run_one()
+    template <typename Layout_, size_t DATA_SIZE_>
+    void run_one(const char *layout)
     {
-        typedef mio::parallelism::ring_queue<std::array<char, DATA_SIZE_>> ring_queue_t;
+        typedef mio::parallelism::ring_queue<std::array<char, DATA_SIZE_>, std::allocator<std::array<char, DATA_SIZE_>>, mio::parallelism::dynamic_extent, Layout_> ring_queue_t;
         auto ring_queue_ptr = std::make_unique<ring_queue_t>(4096);
         ring_queue_t &ring_queue = *ring_queue_ptr;
         std::atomic<size_t> array[SIZE] = {0};
@@ -91,19 +93,171 @@ public:
         assert(max == 0);
         assert(min == 0);
 
-        printf("size/%lu byte\t w/%lu ns\t r/%lu ns\n", DATA_SIZE_, write_diff.count() / (SIZE * THREAD_WRITE_NUM), read_diff.count() / (SIZE * THREAD_READ_NUM));
+        printf("layout/%s\t size/%lu byte\t w/%lu ns\t r/%lu ns\n", layout, DATA_SIZE_, write_diff.count() / (SIZE * THREAD_WRITE_NUM), read_diff.count() / (SIZE * THREAD_READ_NUM));
+    }
+
+    template <typename Layout_, size_t... DATA_SIZE_>
+    void run(const char *layout)
+    {
+        (run_one<Layout_, DATA_SIZE_>(layout), ...);
+    }
+
+    //批量读写, 以每个元素的平均耗时计
+    //写者一次 fetch_add 领取 BATCH_SIZE_ 个槽位, 读者一次 CAS 领取至多 BATCH_SIZE_ 个已发布的槽位
+    //读者的批次可能小于 BATCH_SIZE_, 两端的开销不对称
+    template <size_t BATCH_SIZE_, size_t DATA_SIZE_ = 64>
+    void run_batch_one()
+    {
+        typedef mio::parallelism::ring_queue<std::array<char, DATA_SIZE_>> ring_queue_t;
+        auto ring_queue_ptr = std::make_unique<ring_queue_t>(4096);
+        ring_queue_t &ring_queue = *ring_queue_ptr;
+        std::atomic<size_t> array[SIZE] = {0};
+
+        std::chrono::nanoseconds write_diff;
+        std::chrono::nanoseconds read_diff;
+
+        std::thread write_thread[THREAD_WRITE_NUM];
+        std::thread read_thread[THREAD_READ_NUM];
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i] = std::thread([&]() {
+                std::vector<std::array<char, DATA_SIZE_>> data(BATCH_SIZE_);
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < SIZE; i += BATCH_SIZE_)
+                {
+                    size_t count = std::min(BATCH_SIZE_, SIZE - i);
+                    for (size_t n = 0; n < count; n++)
+                        *(size_t *)&data[n][DATA_SIZE_ - sizeof(size_t)] = i + n;
+
+                    ring_queue.push_n(data.begin(), count);
+                }
+                auto end = std::chrono::steady_clock::now();
+                write_diff = end - start;
+            });
+        }
+
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            read_thread[i] = std::thread([&]() {
+                std::vector<std::array<char, DATA_SIZE_>> data(BATCH_SIZE_);
+
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < SIZE;)
+                {
+                    size_t count = ring_queue.pop_n(data.begin(), std::min(BATCH_SIZE_, SIZE - i));
+                    for (size_t n = 0; n < count; n++)
+                    {
+                        size_t index = *(size_t *)&data[n][DATA_SIZE_ - sizeof(size_t)];
+                        array[index]++;
+                    }
+                    i += count;
+                }
+                auto end = std::chrono::steady_clock::now();
+                read_diff = end - start;
+            });
+        }
+
+        for (size_t i = 0; i < THREAD_WRITE_NUM; i++)
+        {
+            write_thread[i].join();
+        }
+
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            read_thread[i].join();
+        }
+
+        size_t max = 0;
+        size_t min = 0;
+        for (size_t i = 0; i < SIZE; i++)
+        {
+            if (array[i] != THREAD_WRITE_NUM)
+            {
+                if (array[i] > THREAD_WRITE_NUM)
+                    max++;
+                else
+                    min++;
+            }
+        }
+
+        assert(max == 0);
+        assert(min == 0);
+
+        printf("batch/%lu\t size/%lu byte\t w/%lu ns\t r/%lu ns\n", BATCH_SIZE_, DATA_SIZE_, write_diff.count() / (SIZE * THREAD_WRITE_NUM), read_diff.count() / (SIZE * THREAD_READ_NUM));
+    }
+
+    template <size_t... BATCH_SIZE_>
+    void run_batch()
+    {
+        (run_batch_one<BATCH_SIZE_>(), ...);
+    }
+
+    //队列预先写满后 多个读者同时以大批量读空, 每个读者在读不到数据时退出
+    template <size_t BATCH_SIZE_>
+    void run_drain_one()
+    {
+        typedef mio::parallelism::ring_queue<size_t> ring_queue_t;
+        auto ring_queue_ptr = std::make_unique<ring_queue_t>(BUF_SIZE);
+        ring_queue_t &ring_queue = *ring_queue_ptr;
+        std::atomic<size_t> array[BUF_SIZE] = {0};
+
+        for (size_t i = 0; i < BUF_SIZE; i++)
+            ring_queue.push(i);
+
+        std::thread read_thread[THREAD_READ_NUM];
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            read_thread[i] = std::thread([&]() {
+                std::vector<size_t> data(BATCH_SIZE_);
+
+                //读到部分批次时返回实际个数, 读空后返回 0
+                for (size_t count; (count = ring_queue.try_pop_n(data.begin(), BATCH_SIZE_));)
+                {
+                    for (size_t n = 0; n < count; n++)
+                        array[data[n]]++;
+                }
+            });
+        }
+
+        for (size_t i = 0; i < THREAD_READ_NUM; i++)
+        {
+            read_thread[i].join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < BUF_SIZE; i++)
+        {
+            assert(array[i] == 1);
+        }
+
+        assert(ring_queue.empty());
+
+        //剩余不足一批时 pop_n 返回已发布的部分
+        ring_queue.push(0);
+        ring_queue.push(1);
+        std::vector<size_t> data(BATCH_SIZE_);
+        assert(ring_queue.pop_n(data.begin(), BATCH_SIZE_) == std::min<size_t>(2, BATCH_SIZE_));
+
+        printf("drain/%lu\t r/%lu ns\n", BATCH_SIZE_, std::chrono::nanoseconds(end - start).count() / BUF_SIZE);
     }
 
-    template <size_t... DATA_SIZE_>
-    void run()
+    template <size_t... BATCH_SIZE_>
+    void run_drain()
     {
-        (run_one<DATA_SIZE_>(), ...);
+        (run_drain_one<BATCH_SIZE_>(), ...);
     }
 };
 
 int main(void)
 {
     verify v;
-    v.run<64, 128, 256, 512, 1024>();
+    v.run<mio::parallelism::layout::padded, 64, 128, 256, 512, 1024>("padded");
+    v.run<mio::parallelism::layout::compact, 8, 16, 64>("compact");
+    v.run_batch<1, 8, 64, 512>();
+    v.run_drain<1, 64, 1000>();
     return 0;
 }
\ No newline at end of file
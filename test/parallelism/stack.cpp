@@ -8,6 +8,7 @@
 #include <thread>
 #include <stack>
 #include <mutex>
+#include <vector>
 
 constexpr size_t SIZE = 10000;
 
@@ -21,6 +22,10 @@ constexpr size_t THREAD_READ_NUM = 16;
 
 using namespace mio::parallelism;
 
+//只有一个弹匣, 线程之间争用时退回单节点的全局空闲链表, 用作弹匣分配器的对照
+template <typename T>
+using depot_allocator = mio::parallelism::allocator<T, 64, 1>;
+
 class verify
 {
 public:
@@ -109,11 +114,65 @@ public:
     {
         (run_one<DATA_SIZE_>(), ...);
     }
+
+    //每个线程交替 push 与 pop, 返回每次操作的平均耗时
+    template <size_t ELIMINATION_NUM_, template <typename> class Allocator_ = mio::parallelism::allocator>
+    size_t run_scaling(size_t thread_num)
+    {
+        auto stack_ptr = std::make_unique<stack<size_t, ELIMINATION_NUM_, Allocator_>>();
+        auto &stack = *stack_ptr;
+
+        std::vector<std::thread> threads;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < thread_num; i++)
+        {
+            threads.emplace_back([&]() {
+                size_t val;
+                for (size_t n = 0; n < SIZE; n++)
+                {
+                    stack.push(n);
+                    stack.pop(val);
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        return std::chrono::nanoseconds(end - start).count() / (SIZE * thread_num * 2);
+    }
+
+    void scaling()
+    {
+        for (size_t thread_num = 1; thread_num <= 64; thread_num *= 2)
+        {
+            size_t elimination = run_scaling<16>(thread_num);
+            size_t plain = run_scaling<0>(thread_num);
+            printf("threads/%lu\t elimination/%lu ns\t plain/%lu ns\n", thread_num, elimination, plain);
+        }
+    }
+
+    //不使用消除, 只比较节点分配器
+    void allocator_scaling()
+    {
+        for (size_t thread_num = 1; thread_num <= 64; thread_num *= 2)
+        {
+            size_t magazine = run_scaling<0>(thread_num);
+            size_t depot = run_scaling<0, depot_allocator>(thread_num);
+            printf("threads/%lu\t magazine/%lu ns\t depot/%lu ns\n", thread_num, magazine, depot);
+        }
+    }
 };
 
 int main(void)
 {
     verify v;
-    v.run<64, 128, 256, 512, 1024>();
+    v.run<8, 16, 64, 128, 256, 512, 1024>();
+    v.scaling();
+    v.allocator_scaling();
     return 0;
 }
\ No newline at end of file